@@ -0,0 +1,41 @@
+#include "accumulator.hpp"
+
+#include <glbinding/gl/functions.h>
+
+accumulator_t::accumulator_t(std::uint32_t width, std::uint32_t height) noexcept
+    : width_{width}
+    , height_{height}
+    , average_{width, height, 0, nullptr, gl::GLenum::GL_RGBA32F, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST}
+{
+}
+
+auto accumulator_t::accumulate(const shader_t &shader, const texture_t<2U> &colour, bool add_frame) noexcept -> void
+{
+    if (!add_frame && frames_ == 0) {
+        return;
+    }
+
+    shader.use();
+    shader.set_uniform("frames", static_cast<std::int32_t>(frames_));
+    shader.set_uniform("add_frame", add_frame);
+
+    gl::glBindImageTexture(0, colour.id(), 0, false, 0, gl::GLenum::GL_READ_WRITE, gl::GLenum::GL_RGBA16F);
+    gl::glBindImageTexture(1, average_.id(), 0, false, 0, gl::GLenum::GL_READ_WRITE, gl::GLenum::GL_RGBA32F);
+    gl::glDispatchCompute((width_ + 7) / 8, (height_ + 7) / 8, 1);
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT | gl::MemoryBarrierMask::GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+                        | gl::MemoryBarrierMask::GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    if (add_frame) {
+        frames_++;
+    }
+}
+
+auto accumulator_t::reset() noexcept -> void
+{
+    frames_ = 0;
+}
+
+auto accumulator_t::frames() const noexcept -> std::uint32_t
+{
+    return frames_;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <cstdint>
+
+// running average of the frames rendered while the view and the parameters stay unchanged, every frame
+// is jittered differently so the average converges to the image of a noise free ray march
+class accumulator_t {
+public:
+    accumulator_t(std::uint32_t width, std::uint32_t height) noexcept;
+
+    // adds colour to the average with accumulate.comp and writes the average back to colour,
+    // without a new frame the average is only written back
+    auto accumulate(const shader_t &shader, const texture_t<2U> &colour, bool add_frame) noexcept -> void;
+    auto reset() noexcept -> void;
+
+    [[nodiscard]] auto frames() const noexcept -> std::uint32_t;
+
+private:
+    std::uint32_t width_{};
+    std::uint32_t height_{};
+    // 32 bit floats so hundreds of frames add up without banding
+    texture_t<2U> average_{};
+    std::uint32_t frames_{};
+};
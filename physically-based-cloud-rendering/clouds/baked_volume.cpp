@@ -0,0 +1,76 @@
+#include "baked_volume.hpp"
+
+#include <algorithm>
+#include <glbinding/gl/functions.h>
+
+baked_volume_t::baked_volume_t(std::uint32_t width, std::uint32_t height, std::uint32_t depth, gl::GLenum internal_format) noexcept
+    : width_{width}
+    , height_{height}
+    , depth_{depth}
+    , internal_format_{internal_format}
+    , textures_{
+          texture_t<3U>{width, height, depth, nullptr, internal_format, gl::GLenum::GL_RED, gl::GLenum::GL_FLOAT},
+          texture_t<3U>{width, height, depth, nullptr, internal_format, gl::GLenum::GL_RED, gl::GLenum::GL_FLOAT}}
+{
+}
+
+auto baked_volume_t::invalidate(bool keep_current, float time) noexcept -> void
+{
+    next_slice_    = 0;
+    valid_         = valid_ && keep_current;
+    building_time_ = time;
+}
+
+auto baked_volume_t::update(const shader_t &shader, std::uint32_t slices) noexcept -> void
+{
+    if (!building()) {
+        return;
+    }
+
+    slices          = std::min(slices, depth_ - next_slice_);
+    const auto back = 1 - current_;
+
+    shader.use();
+    shader.set_uniform("first_slice", next_slice_);
+    gl::glBindImageTexture(0, textures_[back].id(), 0, true, 0, gl::GLenum::GL_WRITE_ONLY, internal_format_);
+    gl::glDispatchCompute((width_ + 7) / 8, (height_ + 7) / 8, slices);
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    next_slice_ += slices;
+    if (!building()) {
+        current_ = back;
+        valid_   = true;
+        time_    = building_time_;
+    }
+}
+
+auto baked_volume_t::bind(std::int32_t unit) const noexcept -> void
+{
+    textures_[current_].bind(unit);
+}
+
+auto baked_volume_t::valid() const noexcept -> bool
+{
+    return valid_;
+}
+
+auto baked_volume_t::building() const noexcept -> bool
+{
+    return next_slice_ < depth_;
+}
+
+auto baked_volume_t::size_in_bytes() const noexcept -> std::size_t
+{
+    const auto texel_size = internal_format_ == gl::GLenum::GL_R16F ? sizeof(std::uint16_t) : sizeof(float);
+    return textures_.size() * width_ * height_ * depth_ * texel_size;
+}
+
+auto baked_volume_t::time() const noexcept -> float
+{
+    return time_;
+}
+
+auto baked_volume_t::building_time() const noexcept -> float
+{
+    return building_time_;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <array>
+#include <cstdint>
+
+// single channel volume over the cloud layer written by a compute shader a few slices per frame,
+// into a back volume which replaces the sampled one once it is complete
+class baked_volume_t {
+public:
+    baked_volume_t(std::uint32_t width, std::uint32_t height, std::uint32_t depth, gl::GLenum internal_format = gl::GLenum::GL_R32F) noexcept;
+
+    // restarts the bake of the clouds at the given time, the current volume is kept for sampling until then if requested
+    auto invalidate(bool keep_current, float time) noexcept -> void;
+    // runs the next slices of the bake, the uniforms of the shader have to be set beforehand
+    auto update(const shader_t &shader, std::uint32_t slices) noexcept -> void;
+    auto bind(std::int32_t unit = -1) const noexcept -> void;
+
+    [[nodiscard]] auto valid() const noexcept -> bool;
+    [[nodiscard]] auto building() const noexcept -> bool;
+    [[nodiscard]] auto size_in_bytes() const noexcept -> std::size_t;
+    // time of the clouds in the sampled volume and in the bake in progress
+    [[nodiscard]] auto time() const noexcept -> float;
+    [[nodiscard]] auto building_time() const noexcept -> float;
+
+private:
+    std::uint32_t                width_{};
+    std::uint32_t                height_{};
+    std::uint32_t                depth_{};
+    gl::GLenum                   internal_format_{};
+    std::array<texture_t<3U>, 2> textures_{};
+    std::size_t                  current_{};
+    std::uint32_t                next_slice_{};
+    bool                         valid_{};
+    float                        time_{};
+    float                        building_time_{};
+};
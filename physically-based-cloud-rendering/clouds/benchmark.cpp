@@ -0,0 +1,141 @@
+#include "benchmark.hpp"
+
+#include "profiler.hpp"
+#include "transforms.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+namespace {
+auto nearest_rank(const std::vector<float> &sorted, float p) -> float
+{
+    return sorted[static_cast<std::size_t>(p * static_cast<float>(sorted.size() - 1) + 0.5F)];
+}
+
+auto write_statistics(std::ofstream &file, const benchmark_statistics_t &statistics) -> void
+{
+    file << "{\"mean\":" << statistics.mean << ",\"min\":" << statistics.min << ",\"p50\":" << statistics.p50 << ",\"p95\":" << statistics.p95
+         << ",\"p99\":" << statistics.p99 << ",\"max\":" << statistics.max << '}';
+}
+} // namespace
+
+auto summarize(std::vector<float> samples) -> benchmark_statistics_t
+{
+    if (samples.empty()) {
+        return {};
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return benchmark_statistics_t{
+        std::accumulate(samples.begin(), samples.end(), 0.0F) / static_cast<float>(samples.size()),
+        samples.front(),
+        nearest_rank(samples, 0.5F),
+        nearest_rank(samples, 0.95F),
+        nearest_rank(samples, 0.99F),
+        samples.back()};
+}
+
+auto write_benchmark_json(const std::string &path, const benchmark_t &benchmark) -> bool
+{
+    auto file{std::ofstream{path}};
+    if (!file) {
+        return false;
+    }
+
+    // names are fixed identifiers of this program and never need escaping
+    file << "{\"width\":" << benchmark.width << ",\"height\":" << benchmark.height << ",\"warmup_frames\":" << benchmark.warmup_frames
+         << ",\"repetitions\":" << benchmark.repetitions << ",\"unit\":\"ms\",\"cases\":[";
+    for (auto i{std::size_t{}}; i < benchmark.cases.size(); i++) {
+        const auto &benchmark_case = benchmark.cases[i];
+        file << (i == 0 ? "\n" : ",\n") << "{\"configuration\":\"" << benchmark_case.configuration << "\",\"view\":\"" << benchmark_case.view
+             << "\",\"sun_elevation\":" << benchmark_case.sun_elevation << ",\"frame\":";
+        write_statistics(file, benchmark_case.frame);
+
+        file << ",\"passes\":{";
+        for (auto j{std::size_t{}}; j < benchmark_case.passes.size(); j++) {
+            const auto &pass = benchmark_case.passes[j];
+            file << (j == 0 ? "" : ",") << '"' << pass.name << "\":{\"gpu\":";
+            write_statistics(file, pass.gpu);
+            file << ",\"cpu\":";
+            write_statistics(file, pass.cpu);
+            file << '}';
+        }
+        file << "}}";
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
+
+auto run_benchmark(const offline_renderer_t &renderer, const command_line_t &command_line) -> void
+{
+    const auto parameters         = renderer.take_parameters();
+    const auto output_framebuffer = framebuffer_t{static_cast<std::uint32_t>(parameters.screen_width),
+                                                  static_cast<std::uint32_t>(parameters.screen_height),
+                                                  1,
+                                                  false,
+                                                  gl::GLenum::GL_RGBA8,
+                                                  gl::GLenum::GL_RGBA,
+                                                  gl::GLenum::GL_UNSIGNED_BYTE};
+    const auto warmup_frames      = command_line.warmup_frames;
+    const auto repetitions        = command_line.repetitions;
+
+    auto benchmark{benchmark_t{parameters.screen_width, parameters.screen_height, warmup_frames, repetitions, {}}};
+    for (auto i{0}; i < static_cast<std::int32_t>(renderer.configurations.size()); i++) {
+        renderer.configuration = i;
+        for (const auto &view: benchmark_views) {
+            for (const auto elevation: benchmark_sun_elevations) {
+                const auto zone = profile_zone_t{"benchmark case", view.name.data()};
+                set_camera_pose(renderer.camera, view.pose);
+                auto case_parameters{renderer.take_parameters()};
+                case_parameters.sun_direction = -glm::vec3{std::cos(radians(elevation)), std::sin(radians(elevation)), 0.0F};
+                renderer.apply_parameters(case_parameters);
+
+                auto frame_times{std::vector<float>{}};
+                auto gpu_times{std::vector<std::vector<float>>{}};
+                auto cpu_times{std::vector<std::vector<float>>{}};
+                for (auto frame{0}; frame < warmup_frames + repetitions; frame++) {
+                    const auto start = std::chrono::high_resolution_clock::now();
+                    render_timed_frame(renderer, &output_framebuffer);
+                    if (frame < warmup_frames) {
+                        continue;
+                    }
+
+                    frame_times.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+                    const auto &gpu = renderer.gpu_timer.last_frame();
+                    const auto &cpu = renderer.gpu_timer.last_frame_cpu();
+                    gpu_times.resize(gpu.size());
+                    cpu_times.resize(cpu.size());
+                    for (auto pass{std::size_t{}}; pass < gpu.size(); pass++) {
+                        gpu_times[pass].push_back(gpu[pass]);
+                        cpu_times[pass].push_back(cpu[pass]);
+                    }
+                }
+
+                auto &benchmark_case =
+                    benchmark.cases.emplace_back(benchmark_case_t{renderer.configurations[i], view.name, elevation, summarize(frame_times), {}});
+                for (auto pass{std::size_t{}}; pass < gpu_times.size(); pass++) {
+                    // passes of earlier cases this one does not run only have zeros
+                    if (std::all_of(gpu_times[pass].begin(), gpu_times[pass].end(), [](float time) { return time == 0.0F; })) {
+                        continue;
+                    }
+                    benchmark_case.passes.push_back(
+                        benchmark_pass_t{renderer.gpu_timer.passes()[pass], summarize(gpu_times[pass]), summarize(cpu_times[pass])});
+                }
+
+                std::cout << benchmark_case.configuration << ", " << benchmark_case.view << ", sun at " << elevation
+                          << " degrees: " << benchmark_case.frame.mean << " ms mean, " << benchmark_case.frame.p95 << " ms p95" << std::endl;
+            }
+        }
+    }
+
+    if (write_benchmark_json(command_line.benchmark_path, benchmark)) {
+        std::cout << "wrote " << command_line.benchmark_path << std::endl;
+    } else {
+        std::cerr << "cannot write " << command_line.benchmark_path << std::endl;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "command_line.hpp"
+#include "offline_renderer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct benchmark_view_t {
+    std::string_view name{};
+    camera_pose_t    pose{};
+};
+
+// views of the 1000m to 4000m layer all built-in configurations share
+inline const auto benchmark_views = std::array{
+    benchmark_view_t{"below", {{0.0F, 10.0F, 0.0F}, 45.0F, 0.0F}},
+    benchmark_view_t{"inside", {{0.0F, 2500.0F, 0.0F}, 0.0F, 0.0F}},
+    benchmark_view_t{"above", {{0.0F, 6000.0F, 0.0F}, -45.0F, 0.0F}},
+    benchmark_view_t{"grazing horizon", {{0.0F, 10.0F, 0.0F}, 2.0F, 0.0F}}};
+
+// degrees above the horizon
+inline constexpr auto benchmark_sun_elevations = std::array{5.0F, 20.0F, 45.0F, 80.0F};
+
+// mean and percentiles of the repetitions of one case
+struct benchmark_statistics_t {
+    float mean{};
+    float min{};
+    float p50{};
+    float p95{};
+    float p99{};
+    float max{};
+};
+
+[[nodiscard]] auto summarize(std::vector<float> samples) -> benchmark_statistics_t;
+
+struct benchmark_pass_t {
+    std::string            name{};
+    benchmark_statistics_t gpu{};
+    benchmark_statistics_t cpu{};
+};
+
+struct benchmark_case_t {
+    std::string_view              configuration{};
+    std::string_view              view{};
+    float                         sun_elevation{};
+    benchmark_statistics_t        frame{};
+    std::vector<benchmark_pass_t> passes{};
+};
+
+struct benchmark_t {
+    std::int32_t                  width{};
+    std::int32_t                  height{};
+    std::int32_t                  warmup_frames{};
+    std::int32_t                  repetitions{};
+    std::vector<benchmark_case_t> cases{};
+};
+
+// one object per case with the wall time of the frame and the gpu and cpu time of every pass, in milliseconds
+auto write_benchmark_json(const std::string &path, const benchmark_t &benchmark) -> bool;
+
+// renders every configuration from every benchmark view under every sun elevation and writes the json to
+// the benchmark path, the passes of a case are timed over the repetitions after the warm up frames, the
+// clouds do not move
+auto run_benchmark(const offline_renderer_t &renderer, const command_line_t &command_line) -> void;
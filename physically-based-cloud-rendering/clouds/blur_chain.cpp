@@ -0,0 +1,105 @@
+#include "blur_chain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glbinding/gl/functions.h>
+
+namespace {
+constexpr auto blur_group_size = 128U;
+} // namespace
+
+blur_chain_t::blur_chain_t(std::uint32_t width, std::uint32_t height) noexcept
+    : width_{width}
+    , height_{height}
+    , downsampled_{width,
+                   height,
+                   0,
+                   nullptr,
+                   gl::GLenum::GL_RGBA16F,
+                   gl::GLenum::GL_RGBA,
+                   gl::GLenum::GL_FLOAT,
+                   gl::GLenum::GL_LINEAR,
+                   gl::GLenum::GL_LINEAR_MIPMAP_NEAREST,
+                   gl::GLenum::GL_CLAMP_TO_EDGE,
+                   gl::GLenum::GL_CLAMP_TO_EDGE}
+    , horizontal_{width,
+                  height,
+                  0,
+                  nullptr,
+                  gl::GLenum::GL_RGBA16F,
+                  gl::GLenum::GL_RGBA,
+                  gl::GLenum::GL_FLOAT,
+                  gl::GLenum::GL_LINEAR,
+                  gl::GLenum::GL_LINEAR_MIPMAP_NEAREST,
+                  gl::GLenum::GL_CLAMP_TO_EDGE,
+                  gl::GLenum::GL_CLAMP_TO_EDGE}
+{
+}
+
+auto blur_chain_t::apply(const texture_t<2U> &target,
+                         std::int32_t         radius,
+                         std::int32_t         downsample_levels,
+                         const shader_t &     downsample_shader,
+                         const shader_t &     blur_shader,
+                         const shader_t &     upsample_shader) const noexcept -> void
+{
+    const auto levels = std::clamp(downsample_levels, 0, max_downsample_levels());
+
+    // every level reads the one above it, the first reads the target
+    downsample_shader.use();
+    downsample_shader.set_uniform("source", 0);
+    for (auto level{1}; level <= levels; level++) {
+        (level == 1 ? target : downsampled_).bind(0);
+        downsample_shader.set_uniform("source_level", level - 1);
+
+        gl::glBindImageTexture(0, downsampled_.id(), level, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA16F);
+        gl::glDispatchCompute(((width_ >> level) + 7) / 8, ((height_ >> level) + 7) / 8, 1);
+        gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    blur_shader.use();
+    blur_shader.set_uniform("source", 0);
+    blur_shader.set_uniform("radius", std::clamp(radius, 1, max_radius));
+
+    const auto &blurred = levels == 0 ? target : downsampled_;
+    blur(blur_shader, blurred, horizontal_, levels, true);
+    blur(blur_shader, horizontal_, blurred, levels, false);
+
+    if (levels == 0) {
+        return;
+    }
+
+    upsample_shader.use();
+    downsampled_.bind(0);
+    upsample_shader.set_uniform("source", 0);
+    upsample_shader.set_uniform("source_level", levels);
+
+    gl::glBindImageTexture(0, target.id(), 0, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA16F);
+    gl::glDispatchCompute((width_ + 7) / 8, (height_ + 7) / 8, 1);
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+auto blur_chain_t::max_downsample_levels() const noexcept -> std::int32_t
+{
+    return static_cast<std::int32_t>(std::floor(std::log2(std::min(width_, height_))));
+}
+
+auto blur_chain_t::blur(const shader_t &shader, const texture_t<2U> &source, const texture_t<2U> &destination, std::int32_t level, bool horizontal) const noexcept
+    -> void
+{
+    const auto width  = std::max(width_ >> level, 1U);
+    const auto height = std::max(height_ >> level, 1U);
+
+    source.bind(0);
+    shader.set_uniform("level", level);
+    shader.set_uniform("horizontal", horizontal);
+    gl::glBindImageTexture(0, destination.id(), level, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA16F);
+
+    // one workgroup per run of blur_group_size texels along the blurred axis
+    if (horizontal) {
+        gl::glDispatchCompute((width + blur_group_size - 1) / blur_group_size, height, 1);
+    } else {
+        gl::glDispatchCompute((height + blur_group_size - 1) / blur_group_size, width, 1);
+    }
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+}
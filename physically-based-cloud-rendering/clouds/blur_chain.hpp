@@ -0,0 +1,37 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <cstdint>
+
+// separable gaussian blur in compute shaders, optionally run on a downsampled copy of the image
+// so a wide radius costs a fraction of the bandwidth of full resolution passes
+class blur_chain_t {
+public:
+    static constexpr auto max_radius = 32;
+
+    blur_chain_t(std::uint32_t width, std::uint32_t height) noexcept;
+
+    // blurs the base level of target in place, downsample_levels halvings happen before the blur
+    // and the result is upsampled back into target
+    auto apply(const texture_t<2U> &target,
+               std::int32_t         radius,
+               std::int32_t         downsample_levels,
+               const shader_t &     downsample_shader,
+               const shader_t &     blur_shader,
+               const shader_t &     upsample_shader) const noexcept -> void;
+
+    [[nodiscard]] auto max_downsample_levels() const noexcept -> std::int32_t;
+
+private:
+    auto blur(const shader_t &shader, const texture_t<2U> &source, const texture_t<2U> &destination, std::int32_t level, bool horizontal) const noexcept
+        -> void;
+
+    std::uint32_t width_{};
+    std::uint32_t height_{};
+    // downsampled copies of the image, level n is the image halved n times
+    texture_t<2U> downsampled_{};
+    // result of the horizontal pass at every level
+    texture_t<2U> horizontal_{};
+};
@@ -0,0 +1,187 @@
+#include "brick_pool.hpp"
+
+#include <algorithm>
+#include <glbinding/gl/functions.h>
+#include <limits>
+
+namespace {
+constexpr auto brick_size        = 8U;
+constexpr auto stored_brick_size = brick_size + 2U;
+// the atlas grows in depth, each layer holds atlas_bricks * atlas_bricks bricks
+constexpr auto atlas_bricks = 32U;
+
+auto make_page_table(std::uint32_t width, std::uint32_t height, std::uint32_t depth) noexcept -> texture_t<3U>
+{
+    return texture_t<3U>{
+        width, height, depth, nullptr, gl::GLenum::GL_R32UI, gl::GLenum::GL_RED_INTEGER, gl::GLenum::GL_UNSIGNED_INT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST};
+}
+} // namespace
+
+brick_pool_t::brick_pool_t(std::uint32_t width, std::uint32_t height, std::uint32_t depth) noexcept
+    : width_{width}
+    , height_{height}
+    , depth_{depth}
+    , pages_{make_page_table(width, height, depth), make_page_table(width, height, depth)}
+{
+    // brick count followed by the packed page of every allocated brick
+    gl::glGenBuffers(1, &brick_list_);
+    gl::glBindBuffer(gl::GLenum::GL_SHADER_STORAGE_BUFFER, brick_list_);
+    gl::glBufferData(gl::GLenum::GL_SHADER_STORAGE_BUFFER,
+                     static_cast<gl::GLsizeiptr>((1U + total_bricks()) * sizeof(std::uint32_t)),
+                     nullptr,
+                     gl::GLenum::GL_DYNAMIC_COPY);
+}
+
+brick_pool_t::~brick_pool_t() noexcept
+{
+    if (count_fence_ != nullptr) {
+        gl::glDeleteSync(count_fence_);
+    }
+    gl::glDeleteBuffers(1, &brick_list_);
+}
+
+auto brick_pool_t::invalidate(bool keep_current, float time) noexcept -> void
+{
+    if (count_fence_ != nullptr) {
+        gl::glDeleteSync(count_fence_);
+        count_fence_ = nullptr;
+    }
+
+    stage_         = stage_t::classify;
+    next_layer_    = 0;
+    valid_         = valid_ && keep_current;
+    building_time_ = time;
+}
+
+auto brick_pool_t::update(const shader_t &classify_shader, const shader_t &fill_shader, std::uint32_t layers, bool wait) noexcept -> void
+{
+    const auto back = 1 - current_;
+    gl::glBindBufferBase(gl::GLenum::GL_SHADER_STORAGE_BUFFER, 0, brick_list_);
+
+    if (stage_ == stage_t::classify) {
+        if (next_layer_ == 0) {
+            constexpr auto zero = std::uint32_t{};
+            gl::glNamedBufferSubData(brick_list_, 0, sizeof(zero), &zero);
+        }
+
+        const auto classified = std::min(layers, depth_ - next_layer_);
+        classify_shader.use();
+        classify_shader.set_uniform("first_layer", next_layer_);
+        gl::glBindImageTexture(0, pages_[back].id(), 0, true, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_R32UI);
+        gl::glDispatchCompute(width_, height_, classified);
+        gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_SHADER_STORAGE_BARRIER_BIT | gl::MemoryBarrierMask::GL_BUFFER_UPDATE_BARRIER_BIT |
+                            gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        next_layer_ += classified;
+        if (next_layer_ < depth_) {
+            return;
+        }
+
+        // the atlas is sized to what the clouds need, the brick count is read once the gpu got there
+        count_fence_ = gl::glFenceSync(gl::GLenum::GL_SYNC_GPU_COMMANDS_COMPLETE, gl::UnusedMask::GL_UNUSED_BIT);
+        stage_       = stage_t::count;
+    }
+
+    if (stage_ == stage_t::count) {
+        const auto status = gl::glClientWaitSync(
+            count_fence_, gl::SyncObjectMask::GL_SYNC_FLUSH_COMMANDS_BIT, wait ? std::numeric_limits<gl::GLuint64>::max() : 0U);
+        if (status == gl::GLenum::GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        gl::glDeleteSync(count_fence_);
+        count_fence_ = nullptr;
+
+        gl::glGetNamedBufferSubData(brick_list_, 0, sizeof(allocated_bricks_[back]), &allocated_bricks_[back]);
+
+        const auto atlas_depth = std::max((allocated_bricks_[back] + atlas_bricks * atlas_bricks - 1) / (atlas_bricks * atlas_bricks), 1U);
+        if (atlas_depth != atlas_depths_[back]) {
+            atlases_[back]      = texture_t<3U>{atlas_bricks * stored_brick_size,
+                                           atlas_bricks * stored_brick_size,
+                                           atlas_depth * stored_brick_size,
+                                           nullptr,
+                                           gl::GLenum::GL_R16F,
+                                           gl::GLenum::GL_RED,
+                                           gl::GLenum::GL_FLOAT};
+            atlas_depths_[back] = atlas_depth;
+        }
+
+        next_layer_ = 0;
+        stage_      = stage_t::fill;
+        if (allocated_bricks_[back] == 0) {
+            next_layer_ = atlas_depths_[back];
+        }
+    }
+
+    if (stage_ == stage_t::fill) {
+        const auto filled = std::min(layers, atlas_depths_[back] - next_layer_);
+        if (filled > 0) {
+            fill_shader.use();
+            fill_shader.set_uniform("brick_pages_size",
+                                    glm::ivec3{static_cast<std::int32_t>(width_), static_cast<std::int32_t>(height_), static_cast<std::int32_t>(depth_)});
+            fill_shader.set_uniform("first_layer", next_layer_);
+            gl::glBindImageTexture(0, atlases_[back].id(), 0, true, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_R16F);
+            gl::glDispatchCompute(atlas_bricks, atlas_bricks, filled);
+            gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+
+        next_layer_ += filled;
+        if (next_layer_ < atlas_depths_[back]) {
+            return;
+        }
+
+        current_ = back;
+        valid_   = true;
+        time_    = building_time_;
+        stage_   = stage_t::complete;
+    }
+}
+
+auto brick_pool_t::bind(std::int32_t page_unit, std::int32_t atlas_unit) const noexcept -> void
+{
+    pages_[current_].bind(page_unit);
+    atlases_[current_].bind(atlas_unit);
+}
+
+auto brick_pool_t::valid() const noexcept -> bool
+{
+    return valid_;
+}
+
+auto brick_pool_t::building() const noexcept -> bool
+{
+    return stage_ != stage_t::complete;
+}
+
+auto brick_pool_t::allocated_bricks() const noexcept -> std::uint32_t
+{
+    return allocated_bricks_[current_];
+}
+
+auto brick_pool_t::total_bricks() const noexcept -> std::uint32_t
+{
+    return width_ * height_ * depth_;
+}
+
+auto brick_pool_t::size_in_bytes() const noexcept -> std::size_t
+{
+    auto atlas_size{std::size_t{}};
+    for (const auto atlas_depth: atlas_depths_) {
+        atlas_size += static_cast<std::size_t>(atlas_bricks) * atlas_bricks * atlas_depth * stored_brick_size * stored_brick_size * stored_brick_size;
+    }
+    return atlas_size * sizeof(std::uint16_t) + (3U * total_bricks() + 1U) * sizeof(std::uint32_t);
+}
+
+auto brick_pool_t::dense_size_in_bytes() const noexcept -> std::size_t
+{
+    return 2U * static_cast<std::size_t>(total_bricks()) * brick_size * brick_size * brick_size * sizeof(std::uint16_t);
+}
+
+auto brick_pool_t::time() const noexcept -> float
+{
+    return time_;
+}
+
+auto brick_pool_t::building_time() const noexcept -> float
+{
+    return building_time_;
+}
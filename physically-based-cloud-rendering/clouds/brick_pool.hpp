@@ -0,0 +1,64 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <array>
+#include <cstdint>
+
+// sparse bake of the cloud density, 8^3 bricks with a one voxel apron in a 3D atlas and a page table
+// which stores constant (and so empty) bricks directly, built a few layers per frame into a back page
+// table and atlas which replace the sampled ones once they are complete
+class brick_pool_t {
+public:
+    // size of the page table in bricks
+    brick_pool_t(std::uint32_t width, std::uint32_t height, std::uint32_t depth) noexcept;
+    brick_pool_t(const brick_pool_t &) = delete;
+    brick_pool_t(brick_pool_t &&)      = delete; // YAGNI
+    auto operator=(const brick_pool_t &) = delete;
+    auto operator=(brick_pool_t &&) = delete; // YAGNI
+    ~brick_pool_t() noexcept;
+
+    // restarts the build of the clouds at the given time, the current pool is kept for sampling until then if requested
+    auto invalidate(bool keep_current, float time) noexcept -> void;
+    // classifies the next layers of bricks with brick_classify.comp, then waits for the brick count behind a fence
+    // and stores the next layers of varying bricks with brick_fill.comp, wait blocks on the fence instead of
+    // trying again next frame, the cloud density uniforms of both shaders have to be set beforehand
+    auto update(const shader_t &classify_shader, const shader_t &fill_shader, std::uint32_t layers, bool wait) noexcept -> void;
+    auto bind(std::int32_t page_unit, std::int32_t atlas_unit) const noexcept -> void;
+
+    [[nodiscard]] auto valid() const noexcept -> bool;
+    [[nodiscard]] auto building() const noexcept -> bool;
+    [[nodiscard]] auto allocated_bricks() const noexcept -> std::uint32_t;
+    [[nodiscard]] auto total_bricks() const noexcept -> std::uint32_t;
+    [[nodiscard]] auto size_in_bytes() const noexcept -> std::size_t;
+    // size of a dense, double buffered R16F bake at the same resolution
+    [[nodiscard]] auto dense_size_in_bytes() const noexcept -> std::size_t;
+    // time of the clouds in the sampled pool and in the build in progress
+    [[nodiscard]] auto time() const noexcept -> float;
+    [[nodiscard]] auto building_time() const noexcept -> float;
+
+private:
+    enum class stage_t {
+        classify,
+        count,
+        fill,
+        complete
+    };
+
+    std::uint32_t                width_{};
+    std::uint32_t                height_{};
+    std::uint32_t                depth_{};
+    std::array<texture_t<3U>, 2> pages_{};
+    std::array<texture_t<3U>, 2> atlases_{};
+    std::array<std::uint32_t, 2> atlas_depths_{};
+    std::array<std::uint32_t, 2> allocated_bricks_{};
+    std::size_t                  current_{};
+    std::uint32_t                brick_list_{};
+    gl::GLsync                   count_fence_{};
+    stage_t                      stage_{stage_t::complete};
+    std::uint32_t                next_layer_{};
+    bool                         valid_{};
+    float                        time_{};
+    float                        building_time_{};
+};
@@ -0,0 +1,174 @@
+#include "command_line.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+namespace {
+auto print_usage(const char *program) -> void
+{
+    std::cerr << "usage: " << program << " [--headless] [--camera-path file] [--pose x,y,z,pitch,yaw]... [--output directory]\n"
+              << "       [--configuration index] [--frame-time milliseconds] [--trace file] [--record file] [--replay file]\n"
+              << "       [--no-frames] [--benchmark file] [--warmup frames] [--repetitions frames]\n"
+              << "       [--sweep directory]\n"
+              << "  --headless       render offscreen without a window, write every pose of the camera path and exit\n"
+              << "  --camera-path    file with one \"x y z pitch yaw\" pose per line, lines starting with # are skipped\n"
+              << "  --pose           appends a single pose to the camera path\n"
+              << "  --output         directory the frames are written to, frames by default\n"
+              << "  --configuration  index of the cloud configuration, 0 by default\n"
+              << "  --frame-time     cloud animation time between frames, 16.67 ms by default, 0 replays the recorded times\n"
+              << "  --trace          records cpu and gpu zones and writes them as chrome trace json at exit\n"
+              << "  --record         writes the camera and the parameters of every frame of the interactive run to a file\n"
+              << "  --replay         renders every frame of a recording headless and writes per frame timings\n"
+              << "  --no-frames      skips writing the frames of a headless run\n"
+              << "  --benchmark      times every configuration, view and sun elevation headless and writes json\n"
+              << "  --warmup         frames rendered before every benchmark case or sweep setting is measured, 8 by default\n"
+              << "  --repetitions    measured frames of every benchmark case or sweep setting, 32 by default\n"
+              << "  --sweep          renders the benchmark views with every quality setting, compares them against a high\n"
+              << "                   step reference and writes the results and their pareto fronts to a directory" << std::endl;
+}
+
+auto parse_pose(std::string text) -> std::optional<camera_pose_t>
+{
+    std::replace(text.begin(), text.end(), ',', ' ');
+
+    auto stream{std::istringstream{text}};
+    auto pose{camera_pose_t{}};
+    if (!(stream >> pose.position.x >> pose.position.y >> pose.position.z >> pose.pitch >> pose.yaw)) {
+        return std::nullopt;
+    }
+
+    return pose;
+}
+
+// the whole argument has to be a number
+template <typename T>
+auto parse_number(std::string_view text) -> std::optional<T>
+{
+    auto stream{std::istringstream{std::string{text}}};
+    auto value{T{}};
+    if (!(stream >> value) || !(stream >> std::ws).eof()) {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+auto load_camera_path(const std::string &path, std::vector<camera_pose_t> &camera_path) -> bool
+{
+    auto file{std::ifstream{path}};
+    if (!file) {
+        std::cerr << "cannot open camera path " << path << std::endl;
+        return false;
+    }
+
+    auto line{std::string{}};
+    while (std::getline(file, line)) {
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        const auto pose = parse_pose(line);
+        if (!pose) {
+            std::cerr << "invalid pose in " << path << ": " << line << std::endl;
+            return false;
+        }
+        camera_path.push_back(*pose);
+    }
+
+    return true;
+}
+} // namespace
+
+auto parse_command_line(int argc, char **argv) -> std::optional<command_line_t>
+{
+    auto command_line{command_line_t{}};
+
+    for (auto i{1}; i < argc; i++) {
+        const auto argument = std::string_view{argv[i]};
+        const auto has_value = i + 1 < argc;
+
+        if (argument == "--headless") {
+            command_line.headless = true;
+        } else if (argument == "--camera-path" && has_value) {
+            if (!load_camera_path(argv[++i], command_line.camera_path)) {
+                return std::nullopt;
+            }
+        } else if (argument == "--pose" && has_value) {
+            const auto pose = parse_pose(argv[++i]);
+            if (!pose) {
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+            command_line.camera_path.push_back(*pose);
+        } else if (argument == "--output" && has_value) {
+            command_line.output_directory = argv[++i];
+        } else if (argument == "--configuration" && has_value) {
+            const auto configuration = parse_number<std::int32_t>(argv[++i]);
+            if (!configuration || *configuration < 0) {
+                std::cerr << "invalid configuration index " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+            command_line.configuration = *configuration;
+        } else if (argument == "--frame-time" && has_value) {
+            const auto frame_time = parse_number<float>(argv[++i]);
+            if (!frame_time || *frame_time < 0.0F) {
+                std::cerr << "invalid frame time " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+            command_line.frame_time = *frame_time;
+        } else if (argument == "--trace" && has_value) {
+            command_line.trace_path = argv[++i];
+        } else if (argument == "--record" && has_value) {
+            command_line.record_path = argv[++i];
+        } else if (argument == "--replay" && has_value) {
+            command_line.replay_path = argv[++i];
+            command_line.headless    = true;
+        } else if (argument == "--no-frames") {
+            command_line.write_frames = false;
+        } else if (argument == "--benchmark" && has_value) {
+            command_line.benchmark_path = argv[++i];
+            command_line.headless       = true;
+        } else if (argument == "--sweep" && has_value) {
+            command_line.sweep_directory = argv[++i];
+            command_line.headless        = true;
+        } else if (argument == "--warmup" && has_value) {
+            const auto warmup_frames = parse_number<std::int32_t>(argv[++i]);
+            if (!warmup_frames) {
+                std::cerr << "invalid number of warmup frames " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+            command_line.warmup_frames = std::max(*warmup_frames, 0);
+        } else if (argument == "--repetitions" && has_value) {
+            const auto repetitions = parse_number<std::int32_t>(argv[++i]);
+            if (!repetitions) {
+                std::cerr << "invalid number of repetitions " << argv[i] << std::endl;
+                print_usage(argv[0]);
+                return std::nullopt;
+            }
+            command_line.repetitions = std::max(*repetitions, 1);
+        } else {
+            print_usage(argv[0]);
+            return std::nullopt;
+        }
+    }
+
+    if (command_line.headless && command_line.camera_path.empty() && command_line.replay_path.empty() && command_line.benchmark_path.empty() &&
+        command_line.sweep_directory.empty()) {
+        std::cerr << "a headless run needs a camera path, a recording, a benchmark or a sweep" << std::endl;
+        print_usage(argv[0]);
+        return std::nullopt;
+    }
+    if (command_line.headless && !command_line.record_path.empty()) {
+        std::cerr << "only interactive runs can be recorded" << std::endl;
+        print_usage(argv[0]);
+        return std::nullopt;
+    }
+
+    return command_line;
+}
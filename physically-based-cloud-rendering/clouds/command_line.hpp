@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct camera_pose_t {
+    glm::vec3 position{};
+    // degrees, the same convention as transform_t::rotation
+    float pitch{};
+    float yaw{};
+};
+
+// options of a run, without arguments the interactive viewer starts
+struct command_line_t {
+    bool                       headless{false};
+    std::vector<camera_pose_t> camera_path{};
+    std::string                output_directory{"frames"};
+    std::int32_t               configuration{0};
+    // milliseconds of cloud animation between two frames of a headless run
+    float frame_time{1000.0F / 60.0F};
+    // chrome trace of the run, written at exit when set
+    std::string trace_path{};
+    // binary log of the camera and the parameters of every frame of an interactive run
+    std::string record_path{};
+    // renders the frames of a recording headless, at frame_time steps of animation time
+    std::string replay_path{};
+    bool        write_frames{true};
+    // json of the gpu and cpu time of every pass over configurations, views and sun elevations
+    std::string  benchmark_path{};
+    std::int32_t warmup_frames{8};
+    std::int32_t repetitions{32};
+    // directory of the csv and the pareto table of the quality sweep against a high step reference
+    std::string sweep_directory{};
+};
+
+// prints the usage and returns nothing when the arguments are invalid, the configuration index is
+// only known to be non-negative
+[[nodiscard]] auto parse_command_line(int argc, char **argv) -> std::optional<command_line_t>;
@@ -0,0 +1,42 @@
+#include "denoiser.hpp"
+
+#include <glbinding/gl/functions.h>
+
+denoiser_t::denoiser_t(std::uint32_t width, std::uint32_t height) noexcept
+    : width_{width}
+    , height_{height}
+    , ping_{width, height, 0, nullptr, gl::GLenum::GL_RGBA16F, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST}
+    , pong_{width, height, 0, nullptr, gl::GLenum::GL_RGBA16F, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST}
+{
+}
+
+auto denoiser_t::apply(const shader_t &shader, const texture_t<2U> &colour, const texture_t<2U> &cloud_data, std::int32_t iterations) const noexcept
+    -> void
+{
+    if (iterations <= 0) {
+        return;
+    }
+
+    shader.use();
+    cloud_data.bind(1);
+    shader.set_uniform("source", 0);
+    shader.set_uniform("cloud_data", 1);
+
+    // the first iteration reads the colour, the rest alternate between the two scratch targets
+    const auto *source = &colour;
+    for (auto i{0}; i < iterations; i++) {
+        const auto &destination = i % 2 == 0 ? ping_ : pong_;
+
+        source->bind(0);
+        shader.set_uniform("step_width", 1 << i);
+        shader.set_uniform("iteration", i);
+
+        gl::glBindImageTexture(0, destination.id(), 0, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA16F);
+        gl::glDispatchCompute((width_ + 7) / 8, (height_ + 7) / 8, 1);
+        gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT | gl::MemoryBarrierMask::GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+        source = &destination;
+    }
+
+    gl::glCopyImageSubData(source->id(), gl::GLenum::GL_TEXTURE_2D, 0, 0, 0, 0, colour.id(), gl::GLenum::GL_TEXTURE_2D, 0, 0, 0, 0, width_, height_, 1);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <cstdint>
+
+// edge-aware a-trous wavelet filter for the noise of jittered low step counts, guided by the
+// cloud depth and transmittance the ray marcher writes next to the colour
+class denoiser_t {
+public:
+    denoiser_t(std::uint32_t width, std::uint32_t height) noexcept;
+
+    // filters colour in place with denoise.comp, every iteration doubles the spacing of the taps,
+    // the edge stopping parameters are expected to be set on the shader already
+    auto apply(const shader_t &shader, const texture_t<2U> &colour, const texture_t<2U> &cloud_data, std::int32_t iterations) const noexcept -> void;
+
+private:
+    std::uint32_t width_{};
+    std::uint32_t height_{};
+    texture_t<2U> ping_{};
+    texture_t<2U> pong_{};
+};
@@ -0,0 +1,104 @@
+#include "density_bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glbinding/gl/functions.h>
+
+namespace {
+auto make_bounds(std::uint32_t width, std::uint32_t height, std::uint32_t depth) noexcept -> texture_t<3U>
+{
+    return texture_t<3U>{
+        width, height, depth, nullptr, gl::GLenum::GL_RG16F, gl::GLenum::GL_RG, gl::GLenum::GL_FLOAT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST_MIPMAP_NEAREST};
+}
+} // namespace
+
+density_bounds_t::density_bounds_t(std::uint32_t width, std::uint32_t height, std::uint32_t depth) noexcept
+    : width_{width}
+    , height_{height}
+    , depth_{depth}
+    , levels_{static_cast<std::int32_t>(std::floor(std::log2(std::max({width, height, depth})))) + 1}
+    , sampled_{make_bounds(width, height, depth)}
+    , textures_{make_bounds(width, height, depth), make_bounds(width, height, depth)}
+    , next_layer_{depth}
+{
+}
+
+auto density_bounds_t::invalidate(bool keep_current, float time) noexcept -> void
+{
+    next_layer_    = 0;
+    valid_         = valid_ && keep_current;
+    building_time_ = time;
+}
+
+auto density_bounds_t::update(const shader_t &bounds_shader, const shader_t &dilate_shader, const shader_t &reduce_shader, std::uint32_t layers) noexcept
+    -> void
+{
+    if (!building()) {
+        return;
+    }
+
+    layers = std::min(layers, depth_ - next_layer_);
+    bounds_shader.use();
+    bounds_shader.set_uniform("first_layer", next_layer_);
+    gl::glBindImageTexture(0, sampled_.id(), 0, true, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RG16F);
+    gl::glDispatchCompute(width_, height_, layers);
+
+    next_layer_ += layers;
+    if (building()) {
+        return;
+    }
+
+    const auto back = 1 - current_;
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    dilate_shader.use();
+    gl::glBindImageTexture(0, sampled_.id(), 0, true, 0, gl::GLenum::GL_READ_ONLY, gl::GLenum::GL_RG16F);
+    gl::glBindImageTexture(1, textures_[back].id(), 0, true, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RG16F);
+    gl::glDispatchCompute((width_ + 3) / 4, (height_ + 3) / 4, (depth_ + 3) / 4);
+
+    reduce_shader.use();
+    for (auto level{1}; level < levels_; level++) {
+        gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        const auto width  = std::max(width_ >> level, 1U);
+        const auto height = std::max(height_ >> level, 1U);
+        const auto depth  = std::max(depth_ >> level, 1U);
+        gl::glBindImageTexture(0, textures_[back].id(), level - 1, true, 0, gl::GLenum::GL_READ_ONLY, gl::GLenum::GL_RG16F);
+        gl::glBindImageTexture(1, textures_[back].id(), level, true, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RG16F);
+        gl::glDispatchCompute((width + 3) / 4, (height + 3) / 4, (depth + 3) / 4);
+    }
+
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+    current_ = back;
+    valid_   = true;
+    time_    = building_time_;
+}
+
+auto density_bounds_t::bind(std::int32_t unit) const noexcept -> void
+{
+    textures_[current_].bind(unit);
+}
+
+auto density_bounds_t::valid() const noexcept -> bool
+{
+    return valid_;
+}
+
+auto density_bounds_t::building() const noexcept -> bool
+{
+    return next_layer_ < depth_;
+}
+
+auto density_bounds_t::levels() const noexcept -> std::int32_t
+{
+    return levels_;
+}
+
+auto density_bounds_t::time() const noexcept -> float
+{
+    return time_;
+}
+
+auto density_bounds_t::building_time() const noexcept -> float
+{
+    return building_time_;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <array>
+#include <cstdint>
+
+// min/max density of the cloud layer per 8^3 voxel cell, with a mip level for every 2x2x2 reduction,
+// built a few layers of cells per frame into a back hierarchy which replaces the sampled one once it is complete
+class density_bounds_t {
+public:
+    // size of the finest level in cells
+    density_bounds_t(std::uint32_t width, std::uint32_t height, std::uint32_t depth) noexcept;
+
+    // restarts the build of the clouds at the given time, the current hierarchy is kept for sampling until then if requested
+    auto invalidate(bool keep_current, float time) noexcept -> void;
+    // samples the next layers of cells with density_bounds.comp, once every cell is sampled widens each cell to
+    // its neighbours with density_bounds_dilate.comp and reduces the result with density_bounds_reduce.comp,
+    // the cloud density uniforms of the first shader have to be set beforehand
+    auto update(const shader_t &bounds_shader, const shader_t &dilate_shader, const shader_t &reduce_shader, std::uint32_t layers) noexcept
+        -> void;
+    auto bind(std::int32_t unit = -1) const noexcept -> void;
+
+    [[nodiscard]] auto valid() const noexcept -> bool;
+    [[nodiscard]] auto building() const noexcept -> bool;
+    [[nodiscard]] auto levels() const noexcept -> std::int32_t;
+    // time of the clouds in the sampled hierarchy and in the build in progress
+    [[nodiscard]] auto time() const noexcept -> float;
+    [[nodiscard]] auto building_time() const noexcept -> float;
+
+private:
+    std::uint32_t                width_{};
+    std::uint32_t                height_{};
+    std::uint32_t                depth_{};
+    std::int32_t                 levels_{};
+    // bounds of the samples inside every cell before the dilation
+    texture_t<3U>                sampled_{};
+    std::array<texture_t<3U>, 2> textures_{};
+    std::size_t                  current_{};
+    std::uint32_t                next_layer_{};
+    bool                         valid_{};
+    float                        time_{};
+    float                        building_time_{};
+};
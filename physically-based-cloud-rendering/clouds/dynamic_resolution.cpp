@@ -0,0 +1,36 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+dynamic_resolution_t::dynamic_resolution_t(float min_scale, float max_scale) noexcept
+    : min_scale_{min_scale}
+    , max_scale_{max_scale}
+{
+}
+
+auto dynamic_resolution_t::update(float scale, float time, float budget) noexcept -> float
+{
+    if (frames_since_change_ < settle_frames) {
+        frames_since_change_++;
+        return scale;
+    }
+    if (time <= 0.0F || budget <= 0.0F || std::abs(time - budget) <= tolerance * budget) {
+        return scale;
+    }
+
+    // a full step in the direction of the error at least, so a time just outside the tolerance
+    // still moves the scale
+    auto target = std::round(scale * std::sqrt(budget / time) / scale_step) * scale_step;
+    if (time > budget) {
+        target = std::min(target, scale - scale_step);
+    } else {
+        target = std::max(target, scale + scale_step);
+    }
+    target = std::clamp(target, min_scale_, max_scale_);
+
+    if (target != scale) {
+        frames_since_change_ = 0;
+    }
+    return target;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// picks the internal render scale so the ray march time approaches a budget, the cost of the ray march
+// grows with the number of pixels, so the scale per axis follows the square root of budget over time,
+// changes are quantized and held for a few frames since the timings of a new resolution only arrive
+// after the frames in flight of the gpu timer
+class dynamic_resolution_t {
+public:
+    static constexpr auto scale_step = 0.05F;
+
+    dynamic_resolution_t(float min_scale, float max_scale) noexcept;
+
+    // time of the last frames at the current scale and the budget in milliseconds, returns the scale of
+    // the next frame, a time of 0 (no timings yet) keeps the scale
+    auto update(float scale, float time, float budget) noexcept -> float;
+
+private:
+    // times within this fraction of the budget leave the scale alone
+    static constexpr auto tolerance     = 0.1F;
+    static constexpr auto settle_frames = 16;
+
+    float        min_scale_{};
+    float        max_scale_{};
+    std::int32_t frames_since_change_{};
+};
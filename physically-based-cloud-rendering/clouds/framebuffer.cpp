@@ -16,9 +16,15 @@ framebuffer_t::framebuffer_t(std::uint32_t width,
     gl::glGenFramebuffers(1, &id_);
 
     bind();
+    auto draw_buffers{std::vector<gl::GLenum>{}};
     for (auto i{std::uint32_t{}}; i < num_colour_attachments; i++) {
         colour_attachments_.emplace_back(width, height, 0, nullptr, sized_internal_format, format, type);
         glFramebufferTexture2D(gl::GLenum::GL_FRAMEBUFFER, gl::GL_COLOR_ATTACHMENT0 + i, gl::GLenum::GL_TEXTURE_2D, colour_attachments_.back().id(), 0);
+        draw_buffers.push_back(gl::GL_COLOR_ATTACHMENT0 + i);
+    }
+
+    if (draw_buffers.size() > 1) {
+        gl::glDrawBuffers(static_cast<gl::GLsizei>(draw_buffers.size()), draw_buffers.data());
     }
 
     if (depth) {
@@ -44,6 +50,21 @@ auto framebuffer_t::bind() const noexcept -> void
 
 auto framebuffer_t::unbind() noexcept -> void { glBindFramebuffer(gl::GL_FRAMEBUFFER, 0); }
 
+auto framebuffer_t::id() const noexcept -> std::uint32_t
+{
+    return id_;
+}
+
+auto framebuffer_t::width() const noexcept -> std::uint32_t
+{
+    return width_;
+}
+
+auto framebuffer_t::height() const noexcept -> std::uint32_t
+{
+    return height_;
+}
+
 auto framebuffer_t::depth_and_stencil() const noexcept -> const texture_t<2> &
 {
     assert(depth_stencil_);
@@ -25,6 +25,10 @@ public:
     auto        bind() const noexcept -> void;
     static auto unbind() noexcept -> void;
 
+    [[nodiscard]] auto id() const noexcept -> std::uint32_t;
+    [[nodiscard]] auto width() const noexcept -> std::uint32_t;
+    [[nodiscard]] auto height() const noexcept -> std::uint32_t;
+
     [[nodiscard]] auto depth_and_stencil() const noexcept -> const texture_t<2U> &;
     [[nodiscard]] auto depth_and_stencil() noexcept -> texture_t<2U> &;
     [[nodiscard]] auto colour_attachments() const noexcept -> const std::vector<texture_t<2U>> &;
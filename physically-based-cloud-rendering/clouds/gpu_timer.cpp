@@ -0,0 +1,199 @@
+#include "gpu_timer.hpp"
+
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <glbinding/gl/functions.h>
+#include <numeric>
+
+gpu_timer_t::gpu_timer_t(std::size_t history) noexcept
+    : history_{history}
+{
+    auto gpu_now{gl::GLint64{}};
+    gl::glGetInteger64v(gl::GLenum::GL_TIMESTAMP, &gpu_now);
+    gpu_offset_ = profiler_now() - gpu_now;
+}
+
+gpu_timer_t::~gpu_timer_t() noexcept
+{
+    for (auto &frame: frames_) {
+        gl::glDeleteQueries(static_cast<gl::GLsizei>(frame.queries.size()), frame.queries.data());
+        gl::glDeleteQueries(static_cast<gl::GLsizei>(frame.timestamps.size()), frame.timestamps.data());
+    }
+}
+
+auto gpu_timer_t::begin(const std::string &pass) noexcept -> void
+{
+    auto &frame = frames_[current_];
+    if (frame.used == frame.queries.size()) {
+        auto queries{std::array<std::uint32_t, 2>{}};
+        gl::glGenQueries(2, queries.data());
+        frame.queries.push_back(queries[0]);
+        frame.timestamps.push_back(queries[1]);
+        frame.timestamped.push_back(false);
+        frame.cpu_times.push_back(0.0F);
+        frame.passes.push_back(0);
+    }
+
+    frame.passes[frame.used]      = pass_index(pass);
+    frame.timestamped[frame.used] = tracing_enabled();
+    if (frame.timestamped[frame.used]) {
+        gl::glQueryCounter(frame.timestamps[frame.used], gl::GLenum::GL_TIMESTAMP);
+    }
+    gl::glBeginQuery(gl::GLenum::GL_TIME_ELAPSED, frame.queries[frame.used]);
+    frame.used++;
+    cpu_begin_ = profiler_now();
+}
+
+auto gpu_timer_t::end() noexcept -> void
+{
+    gl::glEndQuery(gl::GLenum::GL_TIME_ELAPSED);
+
+    auto &frame                     = frames_[current_];
+    frame.cpu_times[frame.used - 1] = static_cast<float>(profiler_now() - cpu_begin_) / 1000000.0F;
+}
+
+auto gpu_timer_t::next_frame() noexcept -> void
+{
+    current_ = (current_ + 1) % frames_in_flight;
+
+    // queries finish in order, the last one of the frame tells whether the gpu is done with it
+    auto &frame = frames_[current_];
+    if (frame.used > 0) {
+        auto available{gl::GLint{}};
+        gl::glGetQueryObjectiv(frame.queries[frame.used - 1], gl::GLenum::GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            stalls_++;
+        }
+    }
+    collect(frame);
+}
+
+auto gpu_timer_t::flush() noexcept -> void
+{
+    // oldest first, so last_frame() ends up with the current frame
+    for (auto i{1U}; i <= frames_in_flight; i++) {
+        collect(frames_[(current_ + i) % frames_in_flight]);
+    }
+}
+
+auto gpu_timer_t::collect(frame_t &frame) noexcept -> void
+{
+    if (frame.used == 0) {
+        return;
+    }
+
+    // GL_QUERY_RESULT waits for the gpu when the frame is not done yet
+    last_frame_.assign(names_.size(), 0.0F);
+    last_frame_cpu_.assign(names_.size(), 0.0F);
+    for (auto i{std::size_t{}}; i < frame.used; i++) {
+        auto elapsed{gl::GLuint64{}};
+        gl::glGetQueryObjectui64v(frame.queries[i], gl::GLenum::GL_QUERY_RESULT, &elapsed);
+
+        const auto pass         = frame.passes[i];
+        const auto milliseconds = static_cast<float>(elapsed) / 1000000.0F;
+        auto      &samples      = samples_[pass];
+        last_frame_[pass] += milliseconds;
+        last_frame_cpu_[pass] += frame.cpu_times[i];
+        if (samples.size() < history_) {
+            samples.push_back(milliseconds);
+        } else {
+            samples[next_sample_[pass]] = milliseconds;
+        }
+        next_sample_[pass] = (next_sample_[pass] + 1) % history_;
+
+        if (frame.timestamped[i]) {
+            auto begin{gl::GLuint64{}};
+            gl::glGetQueryObjectui64v(frame.timestamps[i], gl::GLenum::GL_QUERY_RESULT, &begin);
+            record_gpu_zone(names_[pass].c_str(), static_cast<std::int64_t>(begin) + gpu_offset_, static_cast<std::int64_t>(elapsed));
+        }
+    }
+
+    frame.used = 0;
+}
+
+auto gpu_timer_t::last_frame() const noexcept -> const std::vector<float> &
+{
+    return last_frame_;
+}
+
+auto gpu_timer_t::last_frame_cpu() const noexcept -> const std::vector<float> &
+{
+    return last_frame_cpu_;
+}
+
+auto gpu_timer_t::stalls() const noexcept -> std::size_t
+{
+    return stalls_;
+}
+
+auto gpu_timer_t::passes() const noexcept -> const std::deque<std::string> &
+{
+    return names_;
+}
+
+auto gpu_timer_t::percentile(std::size_t pass, float p) const -> float
+{
+    auto samples = samples_[pass];
+    if (samples.empty()) {
+        return 0.0F;
+    }
+
+    const auto index = static_cast<std::size_t>(std::clamp(p, 0.0F, 1.0F) * static_cast<float>(samples.size() - 1) + 0.5F);
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+    return samples[index];
+}
+
+auto gpu_timer_t::recent_mean(const std::string &pass, std::size_t frames) const -> float
+{
+    const auto it = std::find(names_.begin(), names_.end(), pass);
+    if (it == names_.end()) {
+        return 0.0F;
+    }
+
+    const auto  index   = static_cast<std::size_t>(it - names_.begin());
+    const auto &samples = samples_[index];
+    const auto  count   = std::min(frames, samples.size());
+    if (count == 0) {
+        return 0.0F;
+    }
+
+    // walks back from the newest sample of the ring
+    auto sum{0.0F};
+    for (auto i{std::size_t{}}; i < count; i++) {
+        sum += samples[(next_sample_[index] + samples.size() - 1 - i) % samples.size()];
+    }
+    return sum / static_cast<float>(count);
+}
+
+auto gpu_timer_t::write_csv(const std::string &path) const -> bool
+{
+    auto file{std::ofstream{path}};
+    if (!file) {
+        return false;
+    }
+
+    file << "pass,samples,mean_ms,p50_ms,p95_ms,p99_ms\n";
+    for (auto i{std::size_t{}}; i < names_.size(); i++) {
+        const auto &samples = samples_[i];
+        const auto  mean    = samples.empty() ? 0.0F : std::accumulate(samples.begin(), samples.end(), 0.0F) / static_cast<float>(samples.size());
+        file << names_[i] << ',' << samples.size() << ',' << mean << ',' << percentile(i, 0.5F) << ',' << percentile(i, 0.95F) << ','
+             << percentile(i, 0.99F) << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+auto gpu_timer_t::pass_index(const std::string &pass) -> std::size_t
+{
+    const auto it = std::find(names_.begin(), names_.end(), pass);
+    if (it != names_.end()) {
+        return static_cast<std::size_t>(it - names_.begin());
+    }
+
+    names_.push_back(pass);
+    samples_.emplace_back();
+    next_sample_.push_back(0);
+    return names_.size() - 1;
+}
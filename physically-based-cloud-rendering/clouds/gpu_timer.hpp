@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// GL_TIME_ELAPSED queries and the cpu time around the passes of a frame, the results are read back a few
+// frames later from a ring of query sets so the cpu rarely waits for the gpu, time elapsed queries cannot nest,
+// while tracing every pass is also recorded as a gpu zone of the profiler
+class gpu_timer_t {
+public:
+    // number of frames of history kept for every pass
+    explicit gpu_timer_t(std::size_t history) noexcept;
+    gpu_timer_t(const gpu_timer_t &) = delete;
+    gpu_timer_t(gpu_timer_t &&)      = delete; // YAGNI
+    auto operator=(const gpu_timer_t &) = delete;
+    auto operator=(gpu_timer_t &&) = delete; // YAGNI
+    ~gpu_timer_t() noexcept;
+
+    auto begin(const std::string &pass) noexcept -> void;
+    auto end() noexcept -> void;
+    // collects the oldest frame of the ring and reuses its queries, waits for it when the gpu is more than
+    // the ring behind, so slow frames are never dropped from the history
+    auto next_frame() noexcept -> void;
+    // waits for and collects every frame in flight, afterwards last_frame() holds the frame just ended
+    auto flush() noexcept -> void;
+
+    [[nodiscard]] auto passes() const noexcept -> const std::deque<std::string> &;
+    // p in [0, 1] of the pass times in milliseconds over the history
+    [[nodiscard]] auto percentile(std::size_t pass, float p) const -> float;
+    // mean time in milliseconds of the last frames of a pass, 0 before its first result
+    [[nodiscard]] auto recent_mean(const std::string &pass, std::size_t frames) const -> float;
+    // time in milliseconds of every pass in the most recently collected frame, 0 for passes it did not run
+    [[nodiscard]] auto last_frame() const noexcept -> const std::vector<float> &;
+    // cpu time in milliseconds between begin() and end() of every pass of the same frame
+    [[nodiscard]] auto last_frame_cpu() const noexcept -> const std::vector<float> &;
+    // number of times next_frame() had to wait for the gpu
+    [[nodiscard]] auto stalls() const noexcept -> std::size_t;
+    // one row per pass with its sample count, mean and percentiles
+    auto write_csv(const std::string &path) const -> bool;
+
+private:
+    static constexpr auto frames_in_flight = 4U;
+
+    struct frame_t {
+        std::vector<std::uint32_t> queries{};
+        // GL_TIMESTAMP at the start of every pass, only issued while tracing
+        std::vector<std::uint32_t> timestamps{};
+        std::vector<bool>          timestamped{};
+        std::vector<float>         cpu_times{};
+        std::vector<std::size_t>   passes{};
+        std::size_t                used{};
+    };
+
+    auto collect(frame_t &frame) noexcept -> void;
+    auto pass_index(const std::string &pass) -> std::size_t;
+
+    std::size_t                           history_{};
+    std::array<frame_t, frames_in_flight> frames_{};
+    std::size_t                           current_{};
+    // a deque so the names handed to the profiler stay where they are
+    std::deque<std::string>               names_{};
+    // ring buffer of the last history_ times of every pass
+    std::vector<std::vector<float>>       samples_{};
+    std::vector<std::size_t>              next_sample_{};
+    std::vector<float>                    last_frame_{};
+    std::vector<float>                    last_frame_cpu_{};
+    std::size_t                           stalls_{};
+    // profiler_now() at the begin() of the open pass
+    std::int64_t                          cpu_begin_{};
+    // profiler_now() minus the gpu timestamp at the same moment
+    std::int64_t                          gpu_offset_{};
+};
@@ -0,0 +1,111 @@
+#include "headless.hpp"
+
+#include "profiler.hpp"
+#include "stb_image_write.h"
+#include "transforms.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <glbinding/gl/functions.h>
+#include <iostream>
+#include <memory>
+
+auto run_headless(const offline_renderer_t &renderer, const command_line_t &command_line, const std::optional<recording_t> &replay) -> void
+{
+    const auto output_directory = std::filesystem::path{command_line.output_directory};
+    std::filesystem::create_directories(output_directory);
+    stbi_flip_vertically_on_write(1);
+
+    // the size of a replay follows the recording
+    auto output_framebuffer{std::unique_ptr<framebuffer_t>{}};
+    auto pixels{std::vector<std::uint8_t>{}};
+
+    // wall clock time of the frame and the gpu time of every pass
+    auto frame_timings{std::vector<std::vector<float>>{}};
+
+    const auto frames = replay ? replay->frames.size() : command_line.camera_path.size();
+    for (auto i{std::size_t{}}; i < frames; i++) {
+        const auto zone = profile_zone_t{"frame"};
+        if (replay) {
+            const auto &frame      = replay->frames[i];
+            auto        parameters = replay->parameters[frame.parameters];
+            // the controllers react to timings, the replay uses the settings they picked during the recording
+            parameters.dynamic_resolution = false;
+            parameters.govern_quality     = false;
+            renderer.apply_parameters(parameters);
+            renderer.camera.transform.position = frame.position;
+            renderer.camera.transform.rotation = frame.rotation;
+            renderer.time                      = command_line.frame_time > 0.0F
+                                                     ? replay->frames.front().time + static_cast<float>(i) * command_line.frame_time
+                                                     : frame.time;
+        } else {
+            set_camera_pose(renderer.camera, command_line.camera_path[i]);
+            renderer.time += command_line.frame_time;
+        }
+
+        const auto parameters = renderer.take_parameters();
+        const auto width      = parameters.screen_width;
+        const auto height     = parameters.screen_height;
+        if (!output_framebuffer || output_framebuffer->width() != static_cast<std::uint32_t>(width) ||
+            output_framebuffer->height() != static_cast<std::uint32_t>(height)) {
+            output_framebuffer = std::make_unique<framebuffer_t>(static_cast<std::uint32_t>(width),
+                                                                 static_cast<std::uint32_t>(height),
+                                                                 1,
+                                                                 false,
+                                                                 gl::GLenum::GL_RGBA8,
+                                                                 gl::GLenum::GL_RGBA,
+                                                                 gl::GLenum::GL_UNSIGNED_BYTE);
+            pixels.resize(static_cast<std::size_t>(width) * height * 4);
+            renderer.camera.projection = perspective(90.0F, static_cast<float>(width) / height, 0.01F, 100000.0F);
+        }
+        renderer.update_render_targets();
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        render_timed_frame(renderer, output_framebuffer.get());
+
+        auto &timings = frame_timings.emplace_back();
+        timings.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        timings.insert(timings.end(), renderer.gpu_timer.last_frame().begin(), renderer.gpu_timer.last_frame().end());
+
+        if (!command_line.write_frames) {
+            continue;
+        }
+
+        output_framebuffer->colour_attachments().front().bind();
+        gl::glGetTexImage(gl::GLenum::GL_TEXTURE_2D, 0, gl::GLenum::GL_RGBA, gl::GLenum::GL_UNSIGNED_BYTE, pixels.data());
+
+        const auto write_zone = profile_zone_t{"write frame"};
+        auto       name{std::array<char, 32>{}};
+        std::snprintf(name.data(), name.size(), "frame_%05zu.png", i);
+        const auto path = output_directory / name.data();
+        if (stbi_write_png(path.string().c_str(), width, height, 4, pixels.data(), width * 4) == 0) {
+            std::cerr << "cannot write " << path.string() << std::endl;
+        } else {
+            std::cout << "wrote " << path.string() << std::endl;
+        }
+    }
+
+    // passes show up as they are first run, frames before that have no column for them
+    const auto frame_timings_path = output_directory / "frame_timings.csv";
+    auto       file{std::ofstream{frame_timings_path}};
+    file << "frame,frame_ms";
+    for (const auto &pass: renderer.gpu_timer.passes()) {
+        file << ',' << pass << "_ms";
+    }
+    file << '\n';
+    for (auto i{std::size_t{}}; i < frame_timings.size(); i++) {
+        file << i;
+        for (auto j{std::size_t{}}; j <= renderer.gpu_timer.passes().size(); j++) {
+            file << ',' << (j < frame_timings[i].size() ? frame_timings[i][j] : 0.0F);
+        }
+        file << '\n';
+    }
+    if (file) {
+        std::cout << "wrote " << frame_timings_path.string() << std::endl;
+    } else {
+        std::cerr << "cannot write " << frame_timings_path.string() << std::endl;
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "command_line.hpp"
+#include "offline_renderer.hpp"
+#include "recording.hpp"
+
+#include <optional>
+
+// renders every pose of the camera path or every frame of the replay at a fixed frame time, writes the
+// tonemapped frames and the timings of every frame to the output directory
+auto run_headless(const offline_renderer_t &renderer, const command_line_t &command_line, const std::optional<recording_t> &replay) -> void;
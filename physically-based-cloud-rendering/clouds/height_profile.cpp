@@ -0,0 +1,100 @@
+#include "height_profile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glbinding/gl/functions.h>
+#include <vector>
+
+namespace {
+constexpr auto eps = 0.1F;
+
+auto remap(float original_value, float original_min, float original_max, float new_min, float new_max) noexcept -> float
+{
+    return new_min + (((original_value - original_min) / (original_max - original_min)) * (new_max - new_min));
+}
+
+auto is_cumulus(float cloud_type) noexcept -> bool
+{
+    return std::abs(cloud_type - 1.0F) < eps;
+}
+
+auto is_stratus(float cloud_type) noexcept -> bool
+{
+    return std::abs(cloud_type) < eps;
+}
+
+auto get_cloud_base(float cloud_type) noexcept -> float
+{
+    return is_cumulus(cloud_type) || is_stratus(cloud_type) ? 0.0F : 0.6F;
+}
+
+auto get_cloud_top(float cloud_type) noexcept -> float
+{
+    return is_stratus(cloud_type) ? 0.3F : 1.0F;
+}
+
+auto get_height_coverage(float relative_height, float cloud_type) noexcept -> float
+{
+    if (is_cumulus(cloud_type) || is_stratus(cloud_type)) {
+        return std::clamp(remap(relative_height, 0.0F, 0.25F, 1.25F, 1.0F), 1.0F, 1.25F);
+    }
+
+    if (relative_height - 0.6F < 0.0F) {
+        return 0.0F;
+    }
+    return std::clamp(remap(relative_height - 0.6F, 0.6F, 0.65F, 1.25F, 1.0F), 1.0F, 1.25F);
+}
+
+auto get_height_gradient(float relative_height, float cloud_type) noexcept -> float
+{
+    if (is_cumulus(cloud_type)) {
+        return std::clamp(remap(relative_height, 0.0F, 0.15F, 0.0F, 1.0F), 0.0F, 1.0F) *
+               std::clamp(remap(relative_height, 0.6F, 1.0F, 1.0F, 0.0F), 0.0F, 1.0F);
+    }
+
+    if (is_stratus(cloud_type)) {
+        return std::clamp(remap(relative_height, 0.0F, 0.05F, 0.0F, 1.0F), 0.0F, 1.0F) *
+               std::clamp(remap(relative_height, 0.2F, 0.3F, 1.0F, 0.0F), 0.0F, 1.0F);
+    }
+
+    return std::clamp(remap(relative_height, 0.6F, 0.65F, 0.0F, 1.0F), 0.0F, 1.0F) *
+           std::clamp(remap(relative_height, 0.9F, 1.0F, 1.0F, 0.0F), 0.0F, 1.0F);
+}
+} // namespace
+
+height_profile_t::height_profile_t(std::uint32_t heights, std::uint32_t cloud_types) noexcept
+    : texture_{heights,
+               cloud_types,
+               0,
+               nullptr,
+               gl::GLenum::GL_RGBA32F,
+               gl::GLenum::GL_RGBA,
+               gl::GLenum::GL_FLOAT,
+               gl::GLenum::GL_LINEAR,
+               gl::GLenum::GL_LINEAR,
+               gl::GLenum::GL_CLAMP_TO_EDGE,
+               gl::GLenum::GL_CLAMP_TO_EDGE}
+{
+    // the end texels hold the end points, the shader samples texel centres
+    auto profile{std::vector<float>(static_cast<std::size_t>(heights) * cloud_types * 4)};
+    for (auto y{std::uint32_t{}}; y < cloud_types; y++) {
+        const auto cloud_type = static_cast<float>(y) / static_cast<float>(cloud_types - 1);
+        for (auto x{std::uint32_t{}}; x < heights; x++) {
+            const auto relative_height = static_cast<float>(x) / static_cast<float>(heights - 1);
+            const auto texel           = (static_cast<std::size_t>(y) * heights + x) * 4;
+
+            profile[texel]     = get_height_gradient(relative_height, cloud_type);
+            profile[texel + 1] = get_height_coverage(relative_height, cloud_type);
+            profile[texel + 2] = get_cloud_base(cloud_type);
+            profile[texel + 3] = get_cloud_top(cloud_type);
+        }
+    }
+
+    texture_.bind();
+    gl::glTexSubImage2D(gl::GLenum::GL_TEXTURE_2D, 0, 0, 0, heights, cloud_types, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, profile.data());
+}
+
+auto height_profile_t::bind(std::int32_t unit) const noexcept -> void
+{
+    texture_.bind(unit);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstdint>
+
+// height gradient, coverage scale, cloud base and cloud top over relative height (x) and cloud type (y),
+// from the same formulas as the height functions in cloud_density.glsl
+class height_profile_t {
+public:
+    height_profile_t(std::uint32_t heights, std::uint32_t cloud_types) noexcept;
+
+    auto bind(std::int32_t unit = -1) const noexcept -> void;
+
+private:
+    texture_t<2U> texture_{};
+};
@@ -0,0 +1,189 @@
+#include "image_metrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glbinding/gl/functions.h>
+
+auto read_texture(const texture_t<2U> &texture, std::uint32_t width, std::uint32_t height) -> std::vector<float>
+{
+    auto pixels{std::vector<float>(static_cast<std::size_t>(width) * height * 4)};
+
+    texture.bind();
+    gl::glGetTexImage(gl::GLenum::GL_TEXTURE_2D, 0, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, pixels.data());
+
+    return pixels;
+}
+
+auto root_mean_square_error(const std::vector<float> &image,
+                            const std::vector<float> &reference,
+                            float                     exposure_factor) -> float
+{
+    assert(image.size() == reference.size());
+
+    const auto expose = [exposure_factor](float value) {
+        return 1.0F - std::exp(-value * exposure_factor);
+    };
+
+    auto sum{0.0};
+    auto count{std::size_t{}};
+    for (auto i{std::size_t{}}; i < image.size(); i++) {
+        // alpha carries no colour information
+        if (i % 4 == 3) {
+            continue;
+        }
+
+        const auto difference = expose(image[i]) - expose(reference[i]);
+        sum += static_cast<double>(difference) * difference;
+        count++;
+    }
+
+    return count == 0 ? 0.0F : static_cast<float>(std::sqrt(sum / static_cast<double>(count)));
+}
+
+auto peak_signal_to_noise_ratio(const std::vector<float> &image,
+                                const std::vector<float> &reference,
+                                float                     exposure_factor) -> float
+{
+    constexpr auto max_psnr = 100.0F;
+
+    const auto error = root_mean_square_error(image, reference, exposure_factor);
+    return error <= 0.0F ? max_psnr : std::min(-20.0F * std::log10(error), max_psnr);
+}
+
+auto structural_similarity(const std::vector<float> &image,
+                           const std::vector<float> &reference,
+                           std::uint32_t             width,
+                           std::uint32_t             height,
+                           float                     exposure_factor) -> float
+{
+    assert(image.size() == reference.size());
+
+    constexpr auto window = 8U;
+    constexpr auto stride = 4U;
+    // stabilizing constants for a dynamic range of 1
+    constexpr auto c1 = 0.01 * 0.01;
+    constexpr auto c2 = 0.03 * 0.03;
+
+    const auto luminance = [exposure_factor](const std::vector<float> &pixels, std::size_t pixel) {
+        const auto expose = [exposure_factor](float value) {
+            return 1.0F - std::exp(-value * exposure_factor);
+        };
+        return static_cast<double>(0.2126F * expose(pixels[pixel * 4]) + 0.7152F * expose(pixels[pixel * 4 + 1]) +
+                                   0.0722F * expose(pixels[pixel * 4 + 2]));
+    };
+
+    auto sum{0.0};
+    auto count{std::size_t{}};
+    for (auto y{0U}; y + window <= height; y += stride) {
+        for (auto x{0U}; x + window <= width; x += stride) {
+            auto mean_x{0.0};
+            auto mean_y{0.0};
+            auto mean_xx{0.0};
+            auto mean_yy{0.0};
+            auto mean_xy{0.0};
+            for (auto j{0U}; j < window; j++) {
+                for (auto i{0U}; i < window; i++) {
+                    const auto pixel = static_cast<std::size_t>(y + j) * width + x + i;
+                    const auto a     = luminance(image, pixel);
+                    const auto b     = luminance(reference, pixel);
+                    mean_x += a;
+                    mean_y += b;
+                    mean_xx += a * a;
+                    mean_yy += b * b;
+                    mean_xy += a * b;
+                }
+            }
+
+            constexpr auto samples = static_cast<double>(window * window);
+            mean_x /= samples;
+            mean_y /= samples;
+            const auto variance_x = mean_xx / samples - mean_x * mean_x;
+            const auto variance_y = mean_yy / samples - mean_y * mean_y;
+            const auto covariance = mean_xy / samples - mean_x * mean_y;
+
+            sum += (2.0 * mean_x * mean_y + c1) * (2.0 * covariance + c2) /
+                   ((mean_x * mean_x + mean_y * mean_y + c1) * (variance_x + variance_y + c2));
+            count++;
+        }
+    }
+
+    return count == 0 ? 1.0F : static_cast<float>(sum / static_cast<double>(count));
+}
+
+auto mean_colour_difference(const std::vector<float> &image,
+                            const std::vector<float> &reference,
+                            float                     exposure_factor) -> float
+{
+    assert(image.size() == reference.size());
+
+    // linear srgb after the exposure and the aces curve of tonemap.frag, before its gamma
+    const auto display = [exposure_factor](float value) {
+        const auto x = static_cast<double>(1.0F - std::exp(-value * exposure_factor));
+        return std::clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+    };
+
+    // d65 white point
+    const auto lab = [&display](const std::vector<float> &pixels, std::size_t pixel) {
+        const auto r = display(pixels[pixel * 4]);
+        const auto g = display(pixels[pixel * 4 + 1]);
+        const auto b = display(pixels[pixel * 4 + 2]);
+
+        const auto f = [](double t) {
+            constexpr auto delta = 6.0 / 29.0;
+            return t > delta * delta * delta ? std::cbrt(t) : t / (3.0 * delta * delta) + 4.0 / 29.0;
+        };
+        const auto fx = f((0.4124 * r + 0.3576 * g + 0.1805 * b) / 0.95047);
+        const auto fy = f(0.2126 * r + 0.7152 * g + 0.0722 * b);
+        const auto fz = f((0.0193 * r + 0.1192 * g + 0.9505 * b) / 1.08883);
+
+        return std::array{116.0 * fy - 16.0, 500.0 * (fx - fy), 200.0 * (fy - fz)};
+    };
+
+    const auto pixels = image.size() / 4;
+    auto       sum{0.0};
+    for (auto i{std::size_t{}}; i < pixels; i++) {
+        const auto a = lab(image, i);
+        const auto b = lab(reference, i);
+        sum += std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+    }
+
+    return pixels == 0 ? 0.0F : static_cast<float>(sum / static_cast<double>(pixels));
+}
+
+auto temporal_deviation(const std::vector<std::vector<float>> &frames, float exposure_factor) -> float
+{
+    if (frames.size() < 2) {
+        return 0.0F;
+    }
+
+    const auto expose = [exposure_factor](float value) {
+        return 1.0F - std::exp(-value * exposure_factor);
+    };
+
+    auto sum{0.0};
+    auto count{std::size_t{}};
+    for (auto i{std::size_t{}}; i < frames.front().size(); i++) {
+        // alpha carries no colour information
+        if (i % 4 == 3) {
+            continue;
+        }
+
+        auto mean{0.0};
+        auto mean_of_squares{0.0};
+        for (const auto &frame: frames) {
+            assert(frame.size() == frames.front().size());
+
+            const auto value = static_cast<double>(expose(frame[i]));
+            mean += value;
+            mean_of_squares += value * value;
+        }
+        mean /= static_cast<double>(frames.size());
+        mean_of_squares /= static_cast<double>(frames.size());
+
+        sum += std::sqrt(std::max(mean_of_squares - mean * mean, 0.0));
+        count++;
+    }
+
+    return count == 0 ? 0.0F : static_cast<float>(sum / static_cast<double>(count));
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// reads back the base level of an RGBA texture as floats
+[[nodiscard]] auto read_texture(const texture_t<2U> &texture, std::uint32_t width, std::uint32_t height) -> std::vector<float>;
+
+// error between two RGBA images after applying the same exposure as tonemap.frag
+[[nodiscard]] auto root_mean_square_error(const std::vector<float> &image,
+                                          const std::vector<float> &reference,
+                                          float                     exposure_factor) -> float;
+
+// psnr in decibels of the exposed images against a peak of 1, capped at 100 for identical images
+[[nodiscard]] auto peak_signal_to_noise_ratio(const std::vector<float> &image,
+                                              const std::vector<float> &reference,
+                                              float                     exposure_factor) -> float;
+
+// mean ssim of the exposed luminance over 8x8 windows placed every 4 pixels
+[[nodiscard]] auto structural_similarity(const std::vector<float> &image,
+                                         const std::vector<float> &reference,
+                                         std::uint32_t             width,
+                                         std::uint32_t             height,
+                                         float                     exposure_factor) -> float;
+
+// mean cie76 colour difference in cielab of the images after exposure and the aces curve of tonemap.frag
+[[nodiscard]] auto mean_colour_difference(const std::vector<float> &image,
+                                          const std::vector<float> &reference,
+                                          float                     exposure_factor) -> float;
+
+// mean standard deviation of every exposed pixel over a sequence of RGBA images of the same size
+[[nodiscard]] auto temporal_deviation(const std::vector<std::vector<float>> &frames, float exposure_factor) -> float;
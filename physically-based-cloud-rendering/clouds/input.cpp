@@ -9,6 +9,7 @@ namespace {
 auto buttons{std::unordered_map<int, bool>{}};
 auto first_mouse{true};
 auto show_options{false};
+auto export_requested{false};
 auto x_offset{0.0F};
 auto y_offset{0.0F};
 auto x{0.0F};
@@ -75,6 +76,10 @@ auto key_callback(GLFWwindow *window, int key, int /*scan_code*/, int action, in
         return;
     }
 
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        export_requested = true;
+    }
+
     if (key == GLFW_KEY_O && action == GLFW_PRESS) {
         if (!show_options) {
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
@@ -105,3 +110,10 @@ auto mouse_callback(GLFWwindow * /*window*/, double x_pos, double y_pos) noexcep
 }
 
 auto options() noexcept -> bool { return show_options; }
+
+auto consume_export_request() noexcept -> bool
+{
+    const auto requested = export_requested;
+    export_requested     = false;
+    return requested;
+}
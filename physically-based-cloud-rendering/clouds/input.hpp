@@ -10,3 +10,5 @@ auto               mouse_callback(GLFWwindow * /*window*/, double x_pos, double
 auto               key_callback(GLFWwindow *window, int key, int /*scan_code*/, int action, int /*mode*/) noexcept -> void;
 auto               process_input(float dt, camera_t &camera) noexcept -> void;
 [[nodiscard]] auto options() noexcept -> bool;
+// true once after 'p' was pressed
+[[nodiscard]] auto consume_export_request() noexcept -> bool;
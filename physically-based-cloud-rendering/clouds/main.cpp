@@ -1,22 +1,53 @@
 #define GLFW_INCLUDE_NONE
 
 #include "GLFW/glfw3.h"
+#include "accumulator.hpp"
+#include "baked_volume.hpp"
+#include "benchmark.hpp"
+#include "blur_chain.hpp"
+#include "brick_pool.hpp"
 #include "camera.hpp"
+#include "command_line.hpp"
+#include "denoiser.hpp"
+#include "density_bounds.hpp"
+#include "dynamic_resolution.hpp"
 #include "framebuffer.hpp"
 #include "glbinding/gl/gl.h"
 #include "glbinding/glbinding.h"
+#include "gpu_timer.hpp"
+#include "headless.hpp"
+#include "height_profile.hpp"
+#include "image_metrics.hpp"
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 #include "input.hpp"
 #include "mesh.hpp"
+#include "multiple_scattering_lut.hpp"
+#include "occupancy_map.hpp"
 #include "preetham.hpp"
+#include "profiler.hpp"
+#include "quality_sweep.hpp"
+#include "quality_governor.hpp"
+#include "ray_cost.hpp"
+#include "recording.hpp"
 #include "shader.hpp"
 #include "stb_image.h"
 #include "transforms.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
 
 struct configuration_t {
     std::string_view weather_map{};
@@ -34,10 +65,89 @@ struct configuration_t {
     float            global_coverage{};
 };
 
-auto main() -> int
+// everything sample_cloud_density depends on apart from time
+struct cloud_density_key_t {
+    std::string_view weather_map{};
+    float            base_scale{};
+    float            detail_scale{};
+    float            weather_scale{};
+    float            detail_factor{};
+    glm::vec3        min{};
+    glm::vec3        max{};
+    float            global_coverage{};
+    glm::vec3        wind_direction{};
+    float            cloud_speed{};
+    float            anvil_bias{};
+    float            coverage_multiplier{};
+    float            density_multiplier{};
+    std::int32_t     visualization{};
+    bool             height_profile{};
+
+    auto operator==(const cloud_density_key_t &) const -> bool = default;
+};
+
+// everything the cached sun optical depth depends on, extinction is applied when sampling
+struct light_volume_key_t {
+    cloud_density_key_t density{};
+    glm::vec3           sun_direction{};
+    std::int32_t        secondary_ray_steps{};
+
+    auto operator==(const light_volume_key_t &) const -> bool = default;
+};
+
+// everything the ray marched image depends on apart from the jitter, progressive refinement restarts
+// when it changes and temporal reprojection discards its history when anything but the camera does
+struct progressive_key_t {
+    cloud_density_key_t density{};
+    glm::vec4           camera_position{};
+    glm::vec3           camera_rotation{};
+    glm::vec3           sun_direction{};
+    float               sun_intensity{};
+    float               turbidity{};
+    float               scattering{};
+    float               extinction{};
+    float               a{};
+    float               b{};
+    float               c{};
+    std::int32_t        octaves{};
+    std::int32_t        primary_ray_steps{};
+    std::int32_t        secondary_ray_steps{};
+    bool                multiple_scattering_approximation{};
+    bool                ambient{};
+    // options that change the image slightly, one bit each
+    std::uint32_t       options{};
+    std::int32_t        resolution_scale{};
+    std::size_t         density_volume_resolution{};
+    std::int32_t        cone_light_steps{};
+    float               cone_spread{};
+    float               erosion_fade_start{};
+    float               erosion_fade_end{};
+
+    auto operator==(const progressive_key_t &) const -> bool = default;
+};
+
+struct pass_report_t {
+    std::string name{};
+    float       frame_time{};
+    float       error{};
+    float       samples_per_pixel{};
+    float       shimmer{};
+};
+
+auto main(int argc, char **argv) -> int
 {
-    constexpr auto screen_width  = 1280;
-    constexpr auto screen_height = 720;
+    const auto command_line = parse_command_line(argc, argv);
+    if (!command_line) {
+        std::exit(-1);
+    }
+    if (!command_line->trace_path.empty()) {
+        enable_tracing();
+    }
+
+    // size of the window, the clouds are rendered at render_scale of it and upscaled by the tonemap,
+    // a replay takes it from the recording
+    auto screen_width{1280};
+    auto screen_height{720};
 
     const auto full_screen_quad_positions = std::vector{
         glm::vec3{-1.0F, -1.0F, 0.0F},
@@ -116,6 +226,12 @@ auto main() -> int
             1.0F},
     };
 
+    if (command_line->configuration >= static_cast<std::int32_t>(configurations.size())) {
+        std::cerr << "invalid configuration index " << command_line->configuration << ", there are " << configurations.size()
+                  << " configurations" << std::endl;
+        std::exit(-1);
+    }
+
     auto weather_maps = std::unordered_map<std::string_view, texture_t<2U>>{};
 
     const auto arr_up = std::array{
@@ -132,8 +248,12 @@ auto main() -> int
         glm::vec3{0, -0.01, 1},
         glm::vec3{0, -0.01, -1}};
 
-    auto radio_button_value{3};
-    auto cfg_value{0};
+    // 2 and 3 visualize the noises, 4 shows the ray cost heatmap
+    constexpr auto ray_cost_heatmap = 4;
+    auto           radio_button_value{3};
+    auto           heatmap_counter{0};
+    auto           heatmap_max_cost{256.0F};
+    auto cfg_value{command_line->configuration};
     auto sun_intensity{1.0F};
     auto anvil_bias{0.0F};
     auto coverage_multiplier{1.0F};
@@ -142,6 +262,13 @@ auto main() -> int
     auto multiple_scattering_approximation{true};
     auto blue_noise{false};
     auto blur{false};
+    auto blur_radius{4};
+    auto blur_downsample_levels{0};
+    auto denoise{false};
+    auto denoise_iterations{4};
+    auto denoise_depth_sigma{0.1F};
+    auto denoise_transmittance_sigma{0.1F};
+    auto denoise_luminance_sigma{0.5F};
     auto ambient{true};
     auto n{16};
     auto primary_ray_steps{64};
@@ -152,8 +279,87 @@ auto main() -> int
     auto wind_direction_normalized{glm::vec3{}};
     auto sun_direction{glm::vec3{0.0F, -1.0F, 0.0F}};
     auto sun_direction_normalized{glm::vec3{}};
+    auto resolution_scale{1};
+    auto render_scale{1.0F};
+    auto dynamic_resolution{false};
+    auto ray_march_budget{8.0F};
+    auto govern_quality{false};
+    auto progressive{false};
+    auto progressive_raise_steps{false};
+    auto progressive_max_frames{256};
+    auto progressive_key{progressive_key_t{}};
+    auto step_multiplier{1};
+    auto blue_noise_offset{glm::vec2{}};
+    auto frame_time_target{16.67F};
+    auto adaptive_step_size{false};
+    auto empty_space_skipping{false};
+    auto temporal_reprojection{false};
+    auto use_light_volume{false};
+    auto volume_slices_per_frame{8};
+    auto use_density_volume{false};
+    auto density_volume_resolution{std::size_t{1}};
+    auto use_brick_pool{false};
+    auto density_bounds_skipping{false};
+    auto count_samples{false};
+    auto use_height_profile{false};
+    auto compute_ray_marching{false};
+    auto compute_segment_steps{16};
+    auto detail_lod{false};
+    auto erosion_fade_start{15000.0F};
+    auto erosion_fade_end{30000.0F};
+
+    // horizontal resolutions go up to ~120m per texel and vertical ones to ~50m for the default cloud layer
+    const auto density_volume_resolutions = std::array{
+        std::array{128U, 16U, 128U},
+        std::array{256U, 32U, 256U},
+        std::array{512U, 64U, 512U}};
+    auto use_multiple_scattering_lut{false};
+    auto cone_light_march{false};
+    auto cone_light_steps{6};
+    auto cone_spread{0.1F};
+
+    // 4x4 ordered dither order, every pixel of a block is marched once every 16 frames
+    constexpr auto temporal_block_size = 4;
+    const auto     temporal_pattern    = std::array{
+        glm::ivec2{0, 0},
+        glm::ivec2{2, 2},
+        glm::ivec2{2, 0},
+        glm::ivec2{0, 2},
+        glm::ivec2{1, 1},
+        glm::ivec2{3, 3},
+        glm::ivec2{3, 1},
+        glm::ivec2{1, 3},
+        glm::ivec2{1, 0},
+        glm::ivec2{3, 2},
+        glm::ivec2{3, 0},
+        glm::ivec2{1, 2},
+        glm::ivec2{0, 1},
+        glm::ivec2{2, 3},
+        glm::ivec2{2, 1},
+        glm::ivec2{0, 3}};
+
+    // comparisons requested from the options window, run at the start of the next frame
+    auto reports{std::vector<pass_report_t>{}};
+    auto pending_report{std::function<void()>{}};
+
+    // a replay takes the camera, the parameters and the time of every frame from the recording
+    auto replay{std::optional<recording_t>{}};
+    if (!command_line->replay_path.empty()) {
+        replay = read_recording(command_line->replay_path,
+                                {static_cast<std::int32_t>(configurations.size()), static_cast<std::int32_t>(density_volume_resolutions.size())});
+        if (!replay) {
+            std::exit(-1);
+        }
+        screen_width      = replay->parameters.front().screen_width;
+        screen_height     = replay->parameters.front().screen_height;
+        camera.projection = perspective(90.0F, static_cast<float>(screen_width) / screen_height, 0.01F, 100000.0F);
+    }
 
-    // init glfw
+    // init glfw, headless runs have no display and render offscreen through an EGL or OSMesa
+    // context of the null platform
+    if (command_line->headless) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
     if (glfwInit() == 0) {
         std::exit(-1);
     }
@@ -161,16 +367,25 @@ auto main() -> int
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_RESIZABLE, 0);
+    glfwWindowHint(GLFW_RESIZABLE, command_line->headless ? 0 : 1);
+    if (command_line->headless) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
 
-    const auto window = glfwCreateWindow(screen_width, screen_height, "clouds", nullptr, nullptr);
+    auto window = glfwCreateWindow(screen_width, screen_height, "clouds", nullptr, nullptr);
+    if (window == nullptr && command_line->headless) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        window = glfwCreateWindow(screen_width, screen_height, "clouds", nullptr, nullptr);
+    }
     if (window == nullptr) {
         std::exit(-1);
     }
 
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!command_line->headless) {
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
 
     glfwMakeContextCurrent(window);
     glfwSwapInterval(0); // disable v-sync
@@ -178,17 +393,36 @@ auto main() -> int
     gl::glViewport(0, 0, screen_width, screen_height);
 
     //init imgui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGui::StyleColorsLight();
+    if (!command_line->headless) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGui::StyleColorsLight();
 
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 460");
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init("#version 460");
+    }
 
     // load textures
     stbi_set_flip_vertically_on_load(1);
-    const auto cloud_base_texture    = texture_t<3U>{128U, 128U, 128U, "textures/noise_shape.tga"};
-    const auto cloud_erosion_texture = texture_t<3U>{64U, 64U, 64U, "textures/noise_erosion_hd.tga"};
+    // the noises are mipmapped for the lod selection of the cone light march and the detail lod
+    const auto cloud_base_texture    = texture_t<3U>{128U,
+                                                  128U,
+                                                  128U,
+                                                  "textures/noise_shape.tga",
+                                                  gl::GLenum::GL_RGBA8,
+                                                  gl::GLenum::GL_RGBA,
+                                                  gl::GLenum::GL_UNSIGNED_BYTE,
+                                                  gl::GLenum::GL_LINEAR,
+                                                  gl::GLenum::GL_LINEAR_MIPMAP_LINEAR};
+    const auto cloud_erosion_texture = texture_t<3U>{64U,
+                                                     64U,
+                                                     64U,
+                                                     "textures/noise_erosion_hd.tga",
+                                                     gl::GLenum::GL_RGBA8,
+                                                     gl::GLenum::GL_RGBA,
+                                                     gl::GLenum::GL_UNSIGNED_BYTE,
+                                                     gl::GLenum::GL_LINEAR,
+                                                     gl::GLenum::GL_LINEAR_MIPMAP_LINEAR};
     const auto mie_texture           = texture_t<1U>{
         1800U,
         0U,
@@ -203,139 +437,1079 @@ auto main() -> int
     weather_maps["custom_cumulus"]            = texture_t<2U>{512U, 512U, 0U, "textures/custom_cumulus.tga"};
     const auto blue_noise_texture             = texture_t<2U>(512U, 512U, 0U, "textures/blue_noise.png");
 
+    auto occupancy_maps = std::unordered_map<std::string_view, occupancy_map_t>{};
+    for (const auto &[name, weather_map]: weather_maps) {
+        const auto zone = profile_zone_t{"read back weather map", name.data()};
+        occupancy_maps.try_emplace(name, weather_map, 512U);
+    }
+
     const auto quad               = mesh_t{full_screen_quad_positions, full_screen_quad_uvs, full_screen_quad_indices};
     const auto raymarching_shader = shader_t{"shaders/raymarch.vert", "shaders/raymarch.frag"};
-    const auto blur_shader        = shader_t{"shaders/raymarch.vert", "shaders/blur.frag"};
     const auto tonemap_shader     = shader_t{"shaders/raymarch.vert", "shaders/tonemap.frag"};
+    const auto heatmap_shader     = shader_t{"shaders/raymarch.vert", "shaders/ray_cost_heatmap.frag"};
+    const auto upsample_shader    = shader_t{"shaders/raymarch.vert", "shaders/upsample.frag"};
+    const auto reproject_shader   = shader_t{"shaders/raymarch.vert", "shaders/reproject.frag"};
+    const auto light_volume_shader = shader_t{"shaders/light_volume.comp"};
+
+    const auto blur_downsample_shader = shader_t{"shaders/blur_downsample.comp"};
+    const auto blur_shader            = shader_t{"shaders/blur.comp"};
+    const auto blur_upsample_shader   = shader_t{"shaders/blur_upsample.comp"};
+    const auto denoise_shader         = shader_t{"shaders/denoise.comp"};
+    const auto accumulate_shader      = shader_t{"shaders/accumulate.comp"};
+
+    // ray marches tiles of 8x8 pixels and compacts the rays still marching between segments
+    const auto raymarching_compute_shader = shader_t{"shaders/raymarch.comp"};
+
+    // one texel per ~470m horizontally and ~95m vertically for the default cloud layer
+    auto light_volume{baked_volume_t{128U, 32U, 128U}};
+    auto light_volume_key{light_volume_key_t{}};
+
+    const auto density_volume_shader = shader_t{"shaders/density_volume.comp"};
+    auto       density_volume{std::unique_ptr<baked_volume_t>{}};
+    auto       density_volume_key{cloud_density_key_t{}};
+    auto       allocated_density_volume_resolution{std::size_t{}};
+
+    // 1024x64x1024 voxels, ~60m per voxel for the default cloud layer
+    const auto brick_classify_shader = shader_t{"shaders/brick_classify.comp"};
+    const auto brick_fill_shader     = shader_t{"shaders/brick_fill.comp"};
+    auto       brick_pool            = brick_pool_t{128U, 8U, 128U};
+    auto       brick_pool_key{cloud_density_key_t{}};
+
+    // finest cells match the bricks of the brick pool
+    const auto density_bounds_shader        = shader_t{"shaders/density_bounds.comp"};
+    const auto density_bounds_dilate_shader = shader_t{"shaders/density_bounds_dilate.comp"};
+    const auto density_bounds_reduce_shader = shader_t{"shaders/density_bounds_reduce.comp"};
+    auto       density_bounds               = density_bounds_t{128U, 8U, 128U};
+    auto       density_bounds_key{cloud_density_key_t{}};
+
+    // 256 relative heights keep the steepest gradient ramp (0.05) over more than ten texels
+    const auto height_profile = height_profile_t{256U, 64U};
+
+    const auto multiple_scattering_shader = shader_t{"shaders/multiple_scattering.comp"};
+    auto       multiple_scattering_lut{multiple_scattering_lut_t{64U, 1024U}};
 
     gl::glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
 
-    // create framebuffers
-    auto framebuffer{framebuffer_t{screen_width, screen_height, 1, true}};
-    auto framebuffer2{framebuffer_t{screen_width, screen_height, 1, true}};
+    // render targets at the internal resolution, reallocated when the window or the render scale changes,
+    // the second attachment of framebuffer2 holds cloud depth and transmittance
+    auto framebuffer2{std::unique_ptr<framebuffer_t>{}};
+    auto blur_chain{std::unique_ptr<blur_chain_t>{}};
+    auto denoiser{std::unique_ptr<denoiser_t>{}};
+    auto ray_cost{std::unique_ptr<ray_cost_t>{}};
+    auto accumulator{std::unique_ptr<accumulator_t>{}};
+
+    // ray marching target for scaled down resolutions, reallocated when the scale changes
+    auto low_resolution_framebuffer{std::unique_ptr<framebuffer_t>{}};
+
+    // resolved colour and cloud data of the previous frame for temporal reprojection
+    auto history_framebuffer{std::unique_ptr<framebuffer_t>{}};
+    auto history_valid{false};
+    auto history_key{progressive_key_t{}};
 
-    auto framebuffer3{framebuffer_t{screen_width, screen_height, 1, true}};
+    // scales between a quarter and the full window resolution in steps of 5%
+    auto dynamic_resolution_controller{dynamic_resolution_t{0.25F, 1.0F}};
+
+    // step counts and octaves the governor may choose from, adjustable in the options window
+    auto quality_governor{quality_governor_t{{{16, 4, 2}, {256, 32, 16}}}};
+    auto previous_view_projection{glm::mat4x4{1.0F}};
+    auto temporal_frame{std::size_t{}};
 
     auto delta_time = 1.0F / 60.0F;
     auto cumulative_time{0.0F};
     auto now = std::chrono::high_resolution_clock::now();
 
-    while (glfwWindowShouldClose(window) == 0) {
-        glfwPollEvents();
+    const auto update_render_targets = [&] {
+        const auto width  = static_cast<std::uint32_t>(std::max(std::lround(static_cast<float>(screen_width) * render_scale), 1L));
+        const auto height = static_cast<std::uint32_t>(std::max(std::lround(static_cast<float>(screen_height) * render_scale), 1L));
+        if (framebuffer2 && framebuffer2->width() == width && framebuffer2->height() == height) {
+            return;
+        }
 
-        delta_time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - now).count();
-        now        = std::chrono::high_resolution_clock::now();
-        cumulative_time += delta_time;
+        framebuffer2        = std::make_unique<framebuffer_t>(width, height, 2, true);
+        history_framebuffer = std::make_unique<framebuffer_t>(width, height, 2, false);
+        blur_chain          = std::make_unique<blur_chain_t>(width, height);
+        denoiser            = std::make_unique<denoiser_t>(width, height);
+        ray_cost            = std::make_unique<ray_cost_t>(width, height);
+        accumulator         = std::make_unique<accumulator_t>(width, height);
+        low_resolution_framebuffer.reset();
+        history_valid = false;
+    };
+    update_render_targets();
 
-        process_input(delta_time, camera);
+    const auto bind_framebuffer2 = [&] {
+        framebuffer2->bind();
+        gl::glViewport(0, 0, static_cast<gl::GLsizei>(framebuffer2->width()), static_cast<gl::GLsizei>(framebuffer2->height()));
+    };
 
-        //std::cout << "Delta time: " << delta_time << std::endl;
+    const auto bind_low_resolution_framebuffer = [&](std::int32_t scale) {
+        const auto width  = std::max(framebuffer2->width() / static_cast<std::uint32_t>(scale), 1U);
+        const auto height = std::max(framebuffer2->height() / static_cast<std::uint32_t>(scale), 1U);
+        if (!low_resolution_framebuffer || low_resolution_framebuffer->width() != width || low_resolution_framebuffer->height() != height) {
+            low_resolution_framebuffer = std::make_unique<framebuffer_t>(width, height, 2, false);
+        }
 
-        // raymarching
+        low_resolution_framebuffer->bind();
+        gl::glViewport(0, 0, static_cast<gl::GLsizei>(width), static_cast<gl::GLsizei>(height));
+    };
+
+    // uniforms of cloud_density.glsl, shared by the ray marcher and the light volume
+    const auto set_cloud_uniforms = [&](const shader_t &shader) {
         auto &cfg = configurations[cfg_value];
-        framebuffer2.bind();
-        glClear(gl::ClearBufferMask::GL_COLOR_BUFFER_BIT | gl::ClearBufferMask::GL_DEPTH_BUFFER_BIT);
-        raymarching_shader.use();
+
         cloud_base_texture.bind(1);
         cloud_erosion_texture.bind(2);
         weather_maps[cfg.weather_map].bind(3);
 
-        raymarching_shader.set_uniform("cloud_base", 1);
-        raymarching_shader.set_uniform("cloud_erosion", 2);
-        raymarching_shader.set_uniform("weather_map", 3);
-        raymarching_shader.set_uniform("use_blue_noise", blue_noise);
+        shader.set_uniform("cloud_base", 1);
+        shader.set_uniform("cloud_erosion", 2);
+        shader.set_uniform("weather_map", 3);
+        shader.set_uniform("low_frequency_noise_visualization", static_cast<int>(radio_button_value == 2));
+        shader.set_uniform("low_freq_noise_scale", cfg.base_scale);
+        shader.set_uniform("weather_map_scale", cfg.weather_scale);
+        shader.set_uniform("high_freq_noise_scale", cfg.detail_scale);
+        shader.set_uniform("high_freq_noise_factor", cfg.detail_factor);
+        shader.set_uniform("time", cumulative_time);
+        shader.set_uniform("cloud_speed", cloud_speed);
+        shader.set_uniform("global_cloud_coverage", cfg.global_coverage);
+        shader.set_uniform("anvil_bias", anvil_bias);
+        wind_direction_normalized = normalize(wind_direction);
+        shader.set_uniform("wind_direction", wind_direction_normalized);
+        shader.set_uniform("coverage_mult", coverage_multiplier);
+        shader.set_uniform("density_mult", density_multiplier);
+        shader.set_uniform("aabb_max", cfg.max);
+        shader.set_uniform("aabb_min", cfg.min);
+
+        height_profile.bind(14);
+        shader.set_uniform("height_profile_lut", 14);
+        shader.set_uniform("use_height_profile", use_height_profile);
+    };
+
+    const auto get_cloud_density_key = [&] {
+        const auto &cfg = configurations[cfg_value];
+        return cloud_density_key_t{
+            cfg.weather_map,
+            cfg.base_scale,
+            cfg.detail_scale,
+            cfg.weather_scale,
+            cfg.detail_factor,
+            cfg.min,
+            cfg.max,
+            cfg.global_coverage,
+            normalize(wind_direction),
+            cloud_speed,
+            anvil_bias,
+            coverage_multiplier,
+            density_multiplier,
+            radio_button_value,
+            use_height_profile};
+    };
+
+    const auto get_progressive_key = [&] {
+        const auto &cfg     = configurations[cfg_value];
+        const auto  options = static_cast<std::uint32_t>(adaptive_step_size) | static_cast<std::uint32_t>(empty_space_skipping) << 1U |
+                             static_cast<std::uint32_t>(temporal_reprojection) << 2U | static_cast<std::uint32_t>(use_light_volume) << 3U |
+                             static_cast<std::uint32_t>(use_density_volume) << 4U | static_cast<std::uint32_t>(use_brick_pool) << 5U |
+                             static_cast<std::uint32_t>(density_bounds_skipping) << 6U |
+                             static_cast<std::uint32_t>(use_multiple_scattering_lut) << 7U | static_cast<std::uint32_t>(cone_light_march) << 8U |
+                             static_cast<std::uint32_t>(detail_lod) << 9U;
+        return progressive_key_t{
+            get_cloud_density_key(),
+            camera.transform.position,
+            camera.transform.rotation,
+            sun_direction,
+            sun_intensity,
+            turbidity,
+            cfg.scattering,
+            cfg.extinction,
+            cfg.a,
+            cfg.b,
+            cfg.c,
+            n,
+            primary_ray_steps,
+            secondary_ray_steps,
+            multiple_scattering_approximation,
+            ambient,
+            options,
+            resolution_scale,
+            density_volume_resolution,
+            cone_light_steps,
+            cone_spread,
+            erosion_fade_start,
+            erosion_fade_end};
+    };
+
+    // restarts a bake of a baked volume or the brick pool when its inputs change, moving clouds keep
+    // the last complete one while the next one is baked
+    const auto restart_bake = [&](auto &volume, bool inputs_changed) {
+        if (inputs_changed) {
+            volume.invalidate(false, cumulative_time);
+        } else if (!volume.building() && cloud_speed > 0.0F) {
+            volume.invalidate(true, cumulative_time);
+        }
+    };
+
+    const auto update_light_volume = [&](std::uint32_t slices) {
+        const auto key = light_volume_key_t{get_cloud_density_key(), normalize(sun_direction), secondary_ray_steps};
+        restart_bake(light_volume, key != light_volume_key);
+        light_volume_key = key;
 
-        if (blue_noise) {
+        if (!light_volume.building()) {
+            return;
+        }
+
+        light_volume_shader.use();
+        set_cloud_uniforms(light_volume_shader);
+        light_volume_shader.set_uniform("time", light_volume.building_time());
+        light_volume_shader.set_uniform("sun_direction", key.sun_direction);
+        light_volume_shader.set_uniform("secondary_ray_steps", secondary_ray_steps);
+        light_volume.update(light_volume_shader, slices);
+    };
+
+    const auto update_density_volume = [&](std::uint32_t slices) {
+        if (!density_volume || allocated_density_volume_resolution != density_volume_resolution) {
+            const auto &[width, height, depth] = density_volume_resolutions[density_volume_resolution];
+            density_volume                      = std::make_unique<baked_volume_t>(width, height, depth, gl::GLenum::GL_R16F);
+            density_volume_key                  = {};
+            allocated_density_volume_resolution = density_volume_resolution;
+        }
+
+        const auto key = get_cloud_density_key();
+        restart_bake(*density_volume, key != density_volume_key);
+        density_volume_key = key;
+
+        if (!density_volume->building()) {
+            return;
+        }
+
+        density_volume_shader.use();
+        set_cloud_uniforms(density_volume_shader);
+        density_volume_shader.set_uniform("time", density_volume->building_time());
+        density_volume->update(density_volume_shader, slices);
+    };
+
+    // layers of bricks are eight voxels deep, wait blocks on the brick count instead of
+    // continuing the build next frame
+    const auto continue_brick_pool = [&](std::uint32_t layers, bool wait) {
+        for (const auto *shader: {&brick_classify_shader, &brick_fill_shader}) {
+            shader->use();
+            set_cloud_uniforms(*shader);
+            shader->set_uniform("time", brick_pool.building_time());
+        }
+        brick_pool.update(brick_classify_shader, brick_fill_shader, layers, wait);
+    };
+
+    const auto update_brick_pool = [&](std::uint32_t layers) {
+        const auto key = get_cloud_density_key();
+        restart_bake(brick_pool, key != brick_pool_key);
+        brick_pool_key = key;
+
+        if (brick_pool.building()) {
+            continue_brick_pool(layers, false);
+        }
+    };
+
+    // the whole build at once for the reports
+    const auto build_brick_pool = [&] {
+        brick_pool.invalidate(false, cumulative_time);
+        brick_pool_key = get_cloud_density_key();
+        continue_brick_pool(std::numeric_limits<std::uint32_t>::max(), true);
+    };
+
+    // layers of cells are eight voxels deep like the layers of bricks
+    const auto continue_density_bounds = [&](std::uint32_t layers) {
+        density_bounds_shader.use();
+        set_cloud_uniforms(density_bounds_shader);
+        density_bounds_shader.set_uniform("time", density_bounds.building_time());
+        density_bounds.update(density_bounds_shader, density_bounds_dilate_shader, density_bounds_reduce_shader, layers);
+    };
+
+    const auto update_density_bounds = [&](std::uint32_t layers) {
+        const auto key = get_cloud_density_key();
+        restart_bake(density_bounds, key != density_bounds_key);
+        density_bounds_key = key;
+
+        if (density_bounds.building()) {
+            continue_density_bounds(layers);
+        }
+    };
+
+    // the whole build at once for the reports
+    const auto build_density_bounds = [&] {
+        density_bounds.invalidate(false, cumulative_time);
+        density_bounds_key = get_cloud_density_key();
+        continue_density_bounds(std::numeric_limits<std::uint32_t>::max());
+    };
+
+    // block size and pixel offset select which pixels are marched, see reproject.frag
+    const auto draw_clouds = [&](const framebuffer_t &target, std::int32_t block_size, glm::ivec2 pixel_offset, bool disoccluded_only) {
+        const auto  zone   = profile_zone_t{"draw clouds"};
+        auto       &cfg    = configurations[cfg_value];
+        const auto &shader = compute_ray_marching ? raymarching_compute_shader : raymarching_shader;
+
+        shader.use();
+        set_cloud_uniforms(shader);
+        shader.set_uniform("use_blue_noise", blue_noise || progressive);
+        shader.set_uniform("blue_noise_offset", blue_noise_offset);
+
+        if (blue_noise || progressive) {
             blue_noise_texture.bind(4);
-            raymarching_shader.set_uniform("blue_noise", 4);
+            shader.set_uniform("blue_noise", 4);
         }
         mie_texture.bind(5);
-        raymarching_shader.set_uniform("mie_texture", 5);
-
-        raymarching_shader.set_uniform("projection", camera.projection);
-        raymarching_shader.set_uniform("view", get_view_matrix(camera.transform));
-        raymarching_shader.set_uniform("camera_pos", glm::vec3{camera.transform.position});
-        raymarching_shader.set_uniform("low_frequency_noise_visualization", static_cast<int>(radio_button_value == 2));
-        raymarching_shader.set_uniform("high_frequency_noise_visualization", static_cast<int>(radio_button_value == 3));
-        raymarching_shader.set_uniform("multiple_scattering_approximation", multiple_scattering_approximation);
-        raymarching_shader.set_uniform("low_freq_noise_scale", cfg.base_scale);
-        raymarching_shader.set_uniform("weather_map_scale", cfg.weather_scale);
-        raymarching_shader.set_uniform("high_freq_noise_scale", cfg.detail_scale);
-        raymarching_shader.set_uniform("scattering_factor", cfg.scattering);
-        raymarching_shader.set_uniform("extinction_factor", cfg.extinction);
-        raymarching_shader.set_uniform("sun_intensity", sun_intensity);
-        raymarching_shader.set_uniform("high_freq_noise_factor", cfg.detail_factor);
-        raymarching_shader.set_uniform("N", n);
-        raymarching_shader.set_uniform("a", cfg.a);
-        raymarching_shader.set_uniform("b", cfg.b);
-        raymarching_shader.set_uniform("c", cfg.c);
-        raymarching_shader.set_uniform("primary_ray_steps", primary_ray_steps);
-        raymarching_shader.set_uniform("secondary_ray_steps", secondary_ray_steps);
-        raymarching_shader.set_uniform("time", cumulative_time);
-        raymarching_shader.set_uniform("cloud_speed", cloud_speed);
-        raymarching_shader.set_uniform("global_cloud_coverage", cfg.global_coverage);
-        raymarching_shader.set_uniform("anvil_bias", anvil_bias);
-        wind_direction_normalized = normalize(wind_direction);
-        raymarching_shader.set_uniform("wind_direction", wind_direction_normalized);
+        shader.set_uniform("mie_texture", 5);
+
+        shader.set_uniform("projection", camera.projection);
+        shader.set_uniform("view", get_view_matrix(camera.transform));
+        shader.set_uniform("camera_pos", glm::vec3{camera.transform.position});
+        shader.set_uniform("high_frequency_noise_visualization", static_cast<int>(radio_button_value == 3));
+        shader.set_uniform("multiple_scattering_approximation", multiple_scattering_approximation);
+        shader.set_uniform("scattering_factor", cfg.scattering);
+        shader.set_uniform("extinction_factor", cfg.extinction);
+        shader.set_uniform("sun_intensity", sun_intensity);
+        shader.set_uniform("N", n);
+        shader.set_uniform("a", cfg.a);
+        shader.set_uniform("b", cfg.b);
+        shader.set_uniform("c", cfg.c);
+        shader.set_uniform("primary_ray_steps", primary_ray_steps * step_multiplier);
+        shader.set_uniform("secondary_ray_steps", secondary_ray_steps * step_multiplier);
         sun_direction_normalized = normalize(sun_direction);
-        raymarching_shader.set_uniform("sun_direction", sun_direction_normalized);
-        raymarching_shader.set_uniform("use_ambient", ambient);
-        raymarching_shader.set_uniform("turbidity", turbidity);
-        raymarching_shader.set_uniform("coverage_mult", coverage_multiplier);
-        raymarching_shader.set_uniform("density_mult", density_multiplier);
-        raymarching_shader.set_uniform("aabb_max", cfg.max);
-        raymarching_shader.set_uniform("aabb_min", cfg.min);
-
-        // use average of 5 samples as ambient radiance
-        // this could really be improved (and done on the GPU as well)
-        auto ambient_luminance_up{glm::vec3{}};
-        for (const auto &el: arr_up) {
-            ambient_luminance_up += 1000.0F * calculate_sky_luminance_RGB(-sun_direction_normalized, el, turbidity);
-        }
-        ambient_luminance_up /= 5.0F;
-        raymarching_shader.set_uniform("ambient_luminance_up", ambient_luminance_up);
-
-        auto ambient_luminance_down{glm::vec3{}};
-        for (const auto &el: arr_down) {
-            ambient_luminance_down += 1000.0F * calculate_sky_luminance_RGB(-sun_direction_normalized, el, turbidity);
-        }
-        ambient_luminance_down /= 5.0F;
-        raymarching_shader.set_uniform("ambient_luminance_down", ambient_luminance_down);
+        shader.set_uniform("sun_direction", sun_direction_normalized);
+        shader.set_uniform("use_ambient", ambient);
+        shader.set_uniform("turbidity", turbidity);
+
+        {
+            // use average of 5 samples as ambient radiance
+            // this could really be improved (and done on the GPU as well)
+            const auto zone = profile_zone_t{"ambient luminance"};
+            auto       ambient_luminance_up{glm::vec3{}};
+            for (const auto &el: arr_up) {
+                ambient_luminance_up += 1000.0F * calculate_sky_luminance_RGB(-sun_direction_normalized, el, turbidity);
+            }
+            ambient_luminance_up /= 5.0F;
+            shader.set_uniform("ambient_luminance_up", ambient_luminance_up);
+
+            auto ambient_luminance_down{glm::vec3{}};
+            for (const auto &el: arr_down) {
+                ambient_luminance_down += 1000.0F * calculate_sky_luminance_RGB(-sun_direction_normalized, el, turbidity);
+            }
+            ambient_luminance_down /= 5.0F;
+            shader.set_uniform("ambient_luminance_down", ambient_luminance_down);
+        }
+
+        auto &occupancy_map = occupancy_maps.at(cfg.weather_map);
+        occupancy_map.update(cfg.global_coverage, coverage_multiplier);
+        occupancy_map.bind(7);
+        shader.set_uniform("occupancy_map", 7);
+        shader.set_uniform("occupancy_levels", occupancy_map.levels());
+        shader.set_uniform("empty_space_skipping", empty_space_skipping);
+
+        light_volume.bind(8);
+        shader.set_uniform("light_volume", 8);
+        shader.set_uniform("use_light_volume", use_light_volume && light_volume.valid());
+        shader.set_uniform("light_volume_time", light_volume.time());
+
+        if (density_volume) {
+            density_volume->bind(10);
+        }
+        shader.set_uniform("density_volume", 10);
+        shader.set_uniform("use_density_volume", use_density_volume && density_volume && density_volume->valid());
+        shader.set_uniform("density_volume_time", density_volume ? density_volume->time() : 0.0F);
+
+        if (brick_pool.valid()) {
+            brick_pool.bind(11, 12);
+        }
+        shader.set_uniform("brick_pages", 11);
+        shader.set_uniform("brick_atlas", 12);
+        shader.set_uniform("use_brick_pool", use_brick_pool && brick_pool.valid());
+        shader.set_uniform("brick_pool_time", brick_pool.time());
+
+        if (density_bounds.valid()) {
+            density_bounds.bind(13);
+        }
+        shader.set_uniform("density_bounds", 13);
+        shader.set_uniform("density_bounds_levels", density_bounds.levels());
+        shader.set_uniform("density_bounds_skipping", density_bounds_skipping && density_bounds.valid());
+        shader.set_uniform("density_bounds_time", density_bounds.time());
+        shader.set_uniform("count_samples", count_samples);
+        shader.set_uniform("count_cost", radio_button_value == ray_cost_heatmap);
+        shader.set_uniform("cost_footprint", block_size > 1 ? 1 : static_cast<std::int32_t>(std::max(framebuffer2->width() / target.width(), 1U)));
 
+        if (use_multiple_scattering_lut) {
+            multiple_scattering_lut.update(multiple_scattering_shader, mie_texture, cfg.a, cfg.b, cfg.c, n);
+            shader.use();
+        }
+        multiple_scattering_lut.bind(9);
+        shader.set_uniform("multiple_scattering_lut", 9);
+        shader.set_uniform("use_multiple_scattering_lut", use_multiple_scattering_lut);
+
+        shader.set_uniform("cone_light_march", cone_light_march);
+        shader.set_uniform("cone_light_steps", cone_light_steps);
+        shader.set_uniform("cone_spread", cone_spread);
+
+        shader.set_uniform("detail_lod", detail_lod);
+        // interleaved blocks march one full resolution ray per texel of the target
+        const auto ray_rows = block_size > 1 ? framebuffer2->height() : target.height();
+        shader.set_uniform("pixel_angle", 2.0F / (camera.projection[1][1] * static_cast<float>(ray_rows)));
+        shader.set_uniform("erosion_fade_start", erosion_fade_start);
+        shader.set_uniform("erosion_fade_end", std::max(erosion_fade_end, erosion_fade_start + 1.0F));
+
+        shader.set_uniform("adaptive_step_size", adaptive_step_size);
+        shader.set_uniform("block_size", block_size);
+        shader.set_uniform("pixel_offset", pixel_offset);
+        shader.set_uniform("output_size", glm::vec2{framebuffer2->width(), framebuffer2->height()});
+        shader.set_uniform("disoccluded_only", disoccluded_only);
+        shader.set_uniform("reprojection_mask", 6);
+
+        if (!compute_ray_marching) {
+            quad.draw();
+            return;
+        }
+
+        // the compute marcher writes both attachments of the target directly
+        shader.set_uniform("segment_steps", compute_segment_steps);
+        for (auto i{0U}; i < 2U; i++) {
+            gl::glBindImageTexture(i, target.colour_attachments()[i].id(), 0, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA16F);
+        }
+        gl::glDispatchCompute((target.width() + 7) / 8, (target.height() + 7) / 8, 1);
+        gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT | gl::MemoryBarrierMask::GL_FRAMEBUFFER_BARRIER_BIT
+                            | gl::MemoryBarrierMask::GL_TEXTURE_UPDATE_BARRIER_BIT);
+    };
+
+    const auto ray_march_pass = [&](std::int32_t scale) {
+        if (scale > 1) {
+            bind_low_resolution_framebuffer(scale);
+        } else {
+            bind_framebuffer2();
+        }
+
+        glClear(gl::ClearBufferMask::GL_COLOR_BUFFER_BIT | gl::ClearBufferMask::GL_DEPTH_BUFFER_BIT);
+        draw_clouds(scale > 1 ? *low_resolution_framebuffer : *framebuffer2, 1, {}, false);
+
+        if (scale > 1) {
+            // reconstruct full resolution guided by cloud depth and transmittance
+            bind_framebuffer2();
+            upsample_shader.use();
+            low_resolution_framebuffer->colour_attachments()[0].bind(0);
+            low_resolution_framebuffer->colour_attachments()[1].bind(1);
+            upsample_shader.set_uniform("low_resolution_colour", 0);
+            upsample_shader.set_uniform("low_resolution_cloud_data", 1);
+            quad.draw();
+        }
+    };
+
+    // marches one pixel of every block per frame and reprojects the rest from the previous frame
+    const auto temporal_pass = [&] {
+        const auto pixel_offset = temporal_pattern[temporal_frame % temporal_pattern.size()];
+        const auto view         = get_view_matrix(camera.transform);
+
+        // the history only follows camera motion, other changes would ghost until every pixel is marched again
+        auto key{get_progressive_key()};
+        key.camera_position = {};
+        key.camera_rotation = {};
+        if (key != history_key) {
+            history_valid = false;
+        }
+        history_key = key;
+
+        bind_low_resolution_framebuffer(temporal_block_size);
+        glClear(gl::ClearBufferMask::GL_COLOR_BUFFER_BIT | gl::ClearBufferMask::GL_DEPTH_BUFFER_BIT);
+        draw_clouds(*low_resolution_framebuffer, temporal_block_size, pixel_offset, false);
+
+        bind_framebuffer2();
+        reproject_shader.use();
+        low_resolution_framebuffer->colour_attachments()[0].bind(0);
+        low_resolution_framebuffer->colour_attachments()[1].bind(1);
+        history_framebuffer->colour_attachments()[0].bind(2);
+        history_framebuffer->colour_attachments()[1].bind(3);
+        reproject_shader.set_uniform("current_colour", 0);
+        reproject_shader.set_uniform("current_cloud_data", 1);
+        reproject_shader.set_uniform("history_colour", 2);
+        reproject_shader.set_uniform("history_cloud_data", 3);
+        reproject_shader.set_uniform("block_size", temporal_block_size);
+        reproject_shader.set_uniform("pixel_offset", pixel_offset);
+        reproject_shader.set_uniform("history_valid", history_valid);
+        reproject_shader.set_uniform("view", view);
+        reproject_shader.set_uniform("projection", camera.projection);
+        reproject_shader.set_uniform("previous_view_projection", previous_view_projection);
+        reproject_shader.set_uniform("camera_pos", glm::vec3{camera.transform.position});
         quad.draw();
 
+        // re-march disocclusions, each pixel reads its own mask texel before writing it
+        gl::glTextureBarrier();
+        framebuffer2->colour_attachments()[1].bind(6);
+        draw_clouds(*framebuffer2, 1, {}, true);
+
+        for (auto i{std::size_t{}}; i < history_framebuffer->colour_attachments().size(); i++) {
+            gl::glCopyImageSubData(framebuffer2->colour_attachments()[i].id(),
+                                   gl::GLenum::GL_TEXTURE_2D,
+                                   0,
+                                   0,
+                                   0,
+                                   0,
+                                   history_framebuffer->colour_attachments()[i].id(),
+                                   gl::GLenum::GL_TEXTURE_2D,
+                                   0,
+                                   0,
+                                   0,
+                                   0,
+                                   static_cast<gl::GLsizei>(framebuffer2->width()),
+                                   static_cast<gl::GLsizei>(framebuffer2->height()),
+                                   1);
+        }
+
+        previous_view_projection = camera.projection * view;
+        history_valid            = true;
+        temporal_frame++;
+    };
+
+    const auto denoise_pass = [&] {
+        denoise_shader.use();
+        denoise_shader.set_uniform("depth_sigma", denoise_depth_sigma);
+        denoise_shader.set_uniform("transmittance_sigma", denoise_transmittance_sigma);
+        denoise_shader.set_uniform("luminance_sigma", denoise_luminance_sigma);
+        denoiser->apply(denoise_shader, framebuffer2->colour_attachments()[0], framebuffer2->colour_attachments()[1], denoise_iterations);
+    };
+
+    // times repeated runs of a pass and compares its output against a reference image, an empty
+    // reference makes this run the reference, prepare runs untimed before every run of the pass
+    const auto measure_prepared_pass = [&](std::string name, const auto &prepare, const auto &pass, const std::vector<float> &reference) {
+        constexpr auto repetitions = 8;
+
+        auto query{std::uint32_t{}};
+        gl::glGenQueries(1, &query);
+
+        // warm up so reallocation of intermediate targets is not measured
+        prepare();
+        pass();
+
+        auto elapsed{gl::GLuint64{}};
+        for (auto i{0}; i < repetitions; i++) {
+            prepare();
+            gl::glBeginQuery(gl::GLenum::GL_TIME_ELAPSED, query);
+            pass();
+            gl::glEndQuery(gl::GLenum::GL_TIME_ELAPSED);
+
+            auto pass_elapsed{gl::GLuint64{}};
+            gl::glGetQueryObjectui64v(query, gl::GLenum::GL_QUERY_RESULT, &pass_elapsed);
+            elapsed += pass_elapsed;
+        }
+        gl::glDeleteQueries(1, &query);
+
+        prepare();
+
+        // one more untimed run counts the density samples the ray marcher takes, in a low and a high word
+        auto sample_counter{std::uint32_t{}};
+        auto density_samples{std::array<std::uint32_t, 2>{}};
+        gl::glGenBuffers(1, &sample_counter);
+        gl::glBindBuffer(gl::GLenum::GL_SHADER_STORAGE_BUFFER, sample_counter);
+        gl::glBufferData(gl::GLenum::GL_SHADER_STORAGE_BUFFER, sizeof(density_samples), density_samples.data(), gl::GLenum::GL_DYNAMIC_READ);
+        gl::glBindBufferBase(gl::GLenum::GL_SHADER_STORAGE_BUFFER, 1, sample_counter);
+        count_samples = true;
+        pass();
+        count_samples = false;
+        gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_BUFFER_UPDATE_BARRIER_BIT);
+        gl::glGetNamedBufferSubData(sample_counter, 0, sizeof(density_samples), density_samples.data());
+        gl::glDeleteBuffers(1, &sample_counter);
+        const auto total_samples = static_cast<std::uint64_t>(density_samples[1]) << 32U | density_samples[0];
+
+        auto image = read_texture(framebuffer2->colour_attachments().front(), framebuffer2->width(), framebuffer2->height());
+
+        const auto &report = reports.emplace_back(pass_report_t{
+            std::move(name),
+            static_cast<float>(elapsed) / 1000000.0F / repetitions,
+            reference.empty() ? 0.0F : root_mean_square_error(image, reference, exposure_factor),
+            static_cast<float>(total_samples) / static_cast<float>(framebuffer2->width() * framebuffer2->height())});
+        std::cout << report.name << ": " << report.frame_time << " ms, rmse " << report.error << ", " << report.samples_per_pixel
+                  << " samples per pixel" << std::endl;
+
+        return image;
+    };
+
+    const auto measure_pass = [&](std::string name, const auto &pass, const std::vector<float> &reference) {
+        return measure_prepared_pass(std::move(name), [] {}, pass, reference);
+    };
+
+    const auto report_resolution_scales = [&] {
+        reports.clear();
+        const auto reference = measure_pass("full resolution", [&] { ray_march_pass(1); }, {});
+        measure_pass("half resolution", [&] { ray_march_pass(2); }, reference);
+        measure_pass("quarter resolution", [&] { ray_march_pass(4); }, reference);
+    };
+
+    // measures the ray march with an option switched off and on, the rmse shows how far the
+    // optimisation changes the image
+    const auto report_option = [&](const char *name, bool &option) {
+        const auto enabled = option;
+        reports.clear();
+
+        option               = false;
+        const auto reference = measure_pass(std::string{name} + " off", [&] { ray_march_pass(1); }, {});
+        option               = true;
+        measure_pass(std::string{name} + " on", [&] { ray_march_pass(1); }, reference);
+
+        option = enabled;
+    };
+
+    // mean deviation of the image while the camera turns by fractions of a pixel, a stable image
+    // barely changes under such motion while aliased detail flickers
+    const auto measure_shimmer = [&](pass_report_t &report, const auto &pass) {
+        constexpr auto frames = 8;
+
+        const auto rotation      = camera.transform.rotation;
+        const auto pixel_degrees = 2.0F * std::atan(1.0F / camera.projection[1][1]) / static_cast<float>(framebuffer2->height()) * (180.0F / pi);
+
+        auto images{std::vector<std::vector<float>>{}};
+        for (auto i{0}; i < frames; i++) {
+            camera.transform.rotation.y = rotation.y + pixel_degrees * static_cast<float>(i) / frames;
+            pass();
+            images.push_back(read_texture(framebuffer2->colour_attachments().front(), framebuffer2->width(), framebuffer2->height()));
+        }
+        camera.transform.rotation = rotation;
+
+        report.shimmer = temporal_deviation(images, exposure_factor);
+        std::cout << report.name << ": shimmer " << report.shimmer << std::endl;
+    };
+
+    const auto report_detail_lod = [&] {
+        const auto enabled = detail_lod;
+        reports.clear();
+
+        detail_lod           = false;
+        const auto reference = measure_pass("detail lod off", [&] { ray_march_pass(1); }, {});
+        measure_shimmer(reports.back(), [&] { ray_march_pass(1); });
+        detail_lod = true;
+        measure_pass("detail lod on", [&] { ray_march_pass(1); }, reference);
+        measure_shimmer(reports.back(), [&] { ray_march_pass(1); });
+
+        detail_lod = enabled;
+    };
+
+    // reduced step counts with and without the denoiser against the full step count, the pose and
+    // the time do not change during a report, so every run is compared against the same frame
+    const auto report_denoiser = [&] {
+        const auto steps = primary_ray_steps;
+        reports.clear();
+
+        const auto reference = measure_pass(std::to_string(steps) + " steps", [&] { ray_march_pass(1); }, {});
+        // the denoiser filters in place, so every run starts from a freshly marched frame
+        measure_prepared_pass("denoiser only", [&] { ray_march_pass(1); }, denoise_pass, {});
+        for (const auto divisor: {2, 3}) {
+            primary_ray_steps = std::max(steps / divisor, 1);
+
+            const auto name = std::to_string(primary_ray_steps) + " steps";
+            measure_pass(name, [&] { ray_march_pass(1); }, reference);
+            measure_pass(
+                name + " denoised",
+                [&] {
+                    ray_march_pass(1);
+                    denoise_pass();
+                },
+                reference);
+        }
+
+        primary_ray_steps = steps;
+    };
+
+    const auto report_light_volume = [&] {
+        const auto enabled = use_light_volume;
+        reports.clear();
+
+        measure_pass(
+            "light volume rebuild",
+            [&] {
+                light_volume.invalidate(true, cumulative_time);
+                update_light_volume(std::numeric_limits<std::uint32_t>::max());
+            },
+            {});
+
+        use_light_volume     = false;
+        const auto reference = measure_pass("light volume off", [&] { ray_march_pass(1); }, {});
+        use_light_volume     = true;
+        measure_pass("light volume on", [&] { ray_march_pass(1); }, reference);
+
+        use_light_volume = enabled;
+    };
+
+    // bake time, memory and error of every density volume resolution against the analytic density
+    const auto report_density_volume = [&] {
+        const auto enabled    = use_density_volume;
+        const auto resolution = density_volume_resolution;
+        reports.clear();
+
+        use_density_volume   = false;
+        const auto reference = measure_pass("analytic density", [&] { ray_march_pass(1); }, {});
+
+        for (auto i{std::size_t{}}; i < density_volume_resolutions.size(); i++) {
+            const auto &[width, height, depth] = density_volume_resolutions[i];
+            density_volume_resolution          = i;
+            update_density_volume(0U);
+
+            auto name = std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(depth) + " (" +
+                        std::to_string(density_volume->size_in_bytes() / (1024 * 1024)) + " MiB)";
+            measure_pass(
+                name + " bake",
+                [&] {
+                    density_volume->invalidate(true, cumulative_time);
+                    update_density_volume(std::numeric_limits<std::uint32_t>::max());
+                },
+                {});
+
+            use_density_volume = true;
+            measure_pass(name + " march", [&] { ray_march_pass(1); }, reference);
+            use_density_volume = false;
+        }
+
+        use_density_volume        = enabled;
+        density_volume_resolution = resolution;
+    };
+
+    // memory and build time of the sparse bake for every configuration
+    const auto report_brick_pool = [&] {
+        const auto configuration = cfg_value;
+        reports.clear();
+
+        for (auto i{0}; i < static_cast<std::int32_t>(configurations.size()); i++) {
+            cfg_value = i;
+            build_brick_pool();
+
+            const auto name = std::string{configurations[i].weather_map} + ": " + std::to_string(brick_pool.allocated_bricks()) + "/" +
+                              std::to_string(brick_pool.total_bricks()) + " bricks, " +
+                              std::to_string(brick_pool.size_in_bytes() / (1024 * 1024)) + " MiB (dense " +
+                              std::to_string(brick_pool.dense_size_in_bytes() / (1024 * 1024)) + " MiB), build";
+            measure_pass(name, build_brick_pool, {});
+        }
+
+        cfg_value = configuration;
+        build_brick_pool();
+    };
+
+    // per pass gpu times of the last 1024 frames, exported with 'p' and at exit
+    auto       gpu_timer{gpu_timer_t{1024}};
+    const auto gpu_timings_path = std::string{"gpu_timings.csv"};
+
+    // every pass of a frame up to the hdr image in framebuffer2
+    const auto render_frame = [&] {
+        const auto zone = profile_zone_t{"render frame"};
+
+        gpu_timer.begin("bakes");
+        if (use_light_volume) {
+            update_light_volume(static_cast<std::uint32_t>(volume_slices_per_frame));
+        }
+        if (use_density_volume) {
+            update_density_volume(static_cast<std::uint32_t>(volume_slices_per_frame));
+        }
+        if (use_brick_pool) {
+            update_brick_pool(static_cast<std::uint32_t>(std::max(volume_slices_per_frame / 8, 1)));
+        }
+        if (density_bounds_skipping) {
+            update_density_bounds(static_cast<std::uint32_t>(std::max(volume_slices_per_frame / 8, 1)));
+        }
+        gpu_timer.end();
+
+        // progressive refinement restarts whenever the image would change, moving clouds change it every frame,
+        // a converged average is reused without marching at all
+        const auto key = get_progressive_key();
+        if (!progressive || key != progressive_key || cloud_speed > 0.0F) {
+            accumulator->reset();
+        }
+        progressive_key = key;
+
+        const auto frames    = accumulator->frames();
+        const auto converged = progressive && frames >= static_cast<std::uint32_t>(progressive_max_frames);
+        // r2 sequence over the texels of the blue noise, integer offsets keep the noise unfiltered
+        const auto r2     = [&](float alpha) { return std::floor(std::fmod(static_cast<float>(frames) * alpha, 1.0F) * 512.0F); };
+        blue_noise_offset = progressive ? glm::vec2{r2(0.7548777F), r2(0.5698403F)} : glm::vec2{};
+        // twice the steps after 32 frames, up to four times after 96
+        step_multiplier = progressive && progressive_raise_steps ? 1 + static_cast<std::int32_t>(std::min(frames / 32U, 3U)) : 1;
+
+        // raymarching
+        if (radio_button_value == ray_cost_heatmap) {
+            ray_cost->begin_frame();
+        }
+        gpu_timer.begin("ray march");
+        if (converged) {
+            // nothing to march, the average is written back below
+        } else if (temporal_reprojection) {
+            temporal_pass();
+        } else {
+            ray_march_pass(resolution_scale);
+            history_valid = false;
+        }
+        gpu_timer.end();
+        if (radio_button_value == ray_cost_heatmap) {
+            ray_cost->end_frame();
+        }
+
+        if (progressive) {
+            gpu_timer.begin("accumulate");
+            accumulator->accumulate(accumulate_shader, framebuffer2->colour_attachments().front(), !converged);
+            gpu_timer.end();
+        }
+
+        if (denoise) {
+            gpu_timer.begin("denoise");
+            denoise_pass();
+            gpu_timer.end();
+        }
+
         if (blur) {
             // gaussian blur
-            auto horizontal = true;
-            auto amount     = 4;
-            blur_shader.use();
-            blur_shader.set_uniform("full_screen", 0);
-            for (auto i = 0; i < amount; i++) {
-                if (horizontal) {
-                    framebuffer3.bind();
-                    framebuffer2.colour_attachments().front().bind(0);
-                } else {
-                    framebuffer2.bind();
-                    framebuffer3.colour_attachments().front().bind(0);
-                }
-                blur_shader.set_uniform("horizontal", horizontal);
-
-                quad.draw();
-                horizontal = !horizontal;
-            }
+            gpu_timer.begin("blur");
+            blur_chain->apply(framebuffer2->colour_attachments().front(),
+                             blur_radius,
+                             blur_downsample_levels,
+                             blur_downsample_shader,
+                             blur_shader,
+                             blur_upsample_shader);
+            gpu_timer.end();
         }
+    };
 
-        framebuffer_t::unbind();
+    // tonemaps framebuffer2 into the bound framebuffer of the window size, upscaling it bilinearly
+    const auto tonemap_pass = [&] {
+        const auto zone = profile_zone_t{"tonemap"};
+        gpu_timer.begin("tonemap");
+        gl::glViewport(0, 0, screen_width, screen_height);
         glClear(gl::ClearBufferMask::GL_COLOR_BUFFER_BIT | gl::ClearBufferMask::GL_DEPTH_BUFFER_BIT);
+        if (radio_button_value == ray_cost_heatmap) {
+            heatmap_shader.use();
+            ray_cost->bind(0);
+            heatmap_shader.set_uniform("ray_cost", 0);
+            heatmap_shader.set_uniform("counter", heatmap_counter);
+            heatmap_shader.set_uniform("max_cost", heatmap_max_cost);
+            quad.draw();
+            gpu_timer.end();
+            return;
+        }
+
         tonemap_shader.use();
 
-        framebuffer2.colour_attachments().front().bind(0);
+        framebuffer2->colour_attachments().front().bind(0);
         tonemap_shader.set_uniform("full_screen", 0);
         tonemap_shader.set_uniform("exposure_factor", exposure_factor);
         quad.draw();
+        gpu_timer.end();
+    };
+
+    const auto export_gpu_timings = [&](const std::string &path) {
+        if (gpu_timer.write_csv(path)) {
+            std::cout << "wrote " << path << std::endl;
+        } else {
+            std::cerr << "cannot write " << path << std::endl;
+        }
+    };
+
+    const auto export_trace = [&] {
+        if (!tracing_enabled()) {
+            return;
+        }
+
+        if (write_trace(command_line->trace_path)) {
+            std::cout << "wrote " << command_line->trace_path << std::endl;
+        } else {
+            std::cerr << "cannot write " << command_line->trace_path << std::endl;
+        }
+    };
+
+    // every option of the viewer and every field of the active configuration, f(snapshot field, option)
+    // is called for each, the configuration index goes first so the fields after it belong to the
+    // configuration it selects
+    const auto visit_parameters = [&](parameter_snapshot_t &snapshot, const auto &f) {
+        f(snapshot.screen_width, screen_width);
+        f(snapshot.screen_height, screen_height);
+
+        f(snapshot.configuration, cfg_value);
+        auto &cfg = configurations[cfg_value];
+        f(snapshot.base_scale, cfg.base_scale);
+        f(snapshot.detail_scale, cfg.detail_scale);
+        f(snapshot.weather_scale, cfg.weather_scale);
+        f(snapshot.detail_factor, cfg.detail_factor);
+        f(snapshot.min, cfg.min);
+        f(snapshot.max, cfg.max);
+        f(snapshot.a, cfg.a);
+        f(snapshot.b, cfg.b);
+        f(snapshot.c, cfg.c);
+        f(snapshot.extinction, cfg.extinction);
+        f(snapshot.scattering, cfg.scattering);
+        f(snapshot.global_coverage, cfg.global_coverage);
+
+        f(snapshot.visualization, radio_button_value);
+        f(snapshot.heatmap_counter, heatmap_counter);
+        f(snapshot.heatmap_max_cost, heatmap_max_cost);
+        f(snapshot.sun_intensity, sun_intensity);
+        f(snapshot.anvil_bias, anvil_bias);
+        f(snapshot.coverage_multiplier, coverage_multiplier);
+        f(snapshot.exposure_factor, exposure_factor);
+        f(snapshot.turbidity, turbidity);
+        f(snapshot.blur_radius, blur_radius);
+        f(snapshot.blur_downsample_levels, blur_downsample_levels);
+        f(snapshot.denoise_iterations, denoise_iterations);
+        f(snapshot.denoise_depth_sigma, denoise_depth_sigma);
+        f(snapshot.denoise_transmittance_sigma, denoise_transmittance_sigma);
+        f(snapshot.denoise_luminance_sigma, denoise_luminance_sigma);
+        f(snapshot.octaves, n);
+        f(snapshot.primary_ray_steps, primary_ray_steps);
+        f(snapshot.secondary_ray_steps, secondary_ray_steps);
+        f(snapshot.cloud_speed, cloud_speed);
+        f(snapshot.density_multiplier, density_multiplier);
+        f(snapshot.wind_direction, wind_direction);
+        f(snapshot.sun_direction, sun_direction);
+        f(snapshot.resolution_scale, resolution_scale);
+        f(snapshot.render_scale, render_scale);
+        f(snapshot.ray_march_budget, ray_march_budget);
+        f(snapshot.frame_time_target, frame_time_target);
+        f(snapshot.progressive_max_frames, progressive_max_frames);
+        f(snapshot.volume_slices_per_frame, volume_slices_per_frame);
+        f(snapshot.density_volume_resolution, density_volume_resolution);
+        f(snapshot.compute_segment_steps, compute_segment_steps);
+        f(snapshot.erosion_fade_start, erosion_fade_start);
+        f(snapshot.erosion_fade_end, erosion_fade_end);
+        f(snapshot.cone_light_steps, cone_light_steps);
+        f(snapshot.cone_spread, cone_spread);
+
+        f(snapshot.multiple_scattering_approximation, multiple_scattering_approximation);
+        f(snapshot.blue_noise, blue_noise);
+        f(snapshot.blur, blur);
+        f(snapshot.denoise, denoise);
+        f(snapshot.ambient, ambient);
+        f(snapshot.dynamic_resolution, dynamic_resolution);
+        f(snapshot.govern_quality, govern_quality);
+        f(snapshot.progressive, progressive);
+        f(snapshot.progressive_raise_steps, progressive_raise_steps);
+        f(snapshot.adaptive_step_size, adaptive_step_size);
+        f(snapshot.empty_space_skipping, empty_space_skipping);
+        f(snapshot.temporal_reprojection, temporal_reprojection);
+        f(snapshot.use_light_volume, use_light_volume);
+        f(snapshot.use_density_volume, use_density_volume);
+        f(snapshot.use_brick_pool, use_brick_pool);
+        f(snapshot.density_bounds_skipping, density_bounds_skipping);
+        f(snapshot.use_height_profile, use_height_profile);
+        f(snapshot.compute_ray_marching, compute_ray_marching);
+        f(snapshot.detail_lod, detail_lod);
+        f(snapshot.use_multiple_scattering_lut, use_multiple_scattering_lut);
+        f(snapshot.cone_light_march, cone_light_march);
+    };
+
+    const auto take_parameter_snapshot = [&] {
+        auto snapshot{parameter_snapshot_t{}};
+        visit_parameters(snapshot, [](auto &field, const auto &option) { field = static_cast<std::remove_reference_t<decltype(field)>>(option); });
+        return snapshot;
+    };
+
+    const auto apply_parameter_snapshot = [&](parameter_snapshot_t snapshot) {
+        visit_parameters(snapshot, [](const auto &field, auto &option) { option = static_cast<std::remove_reference_t<decltype(option)>>(field); });
+    };
+
+    // the benchmark, the quality sweep and headless runs render without the window loop and exit
+    if (!command_line->benchmark_path.empty() || !command_line->sweep_directory.empty() || command_line->headless) {
+        auto configuration_names{std::vector<std::string_view>{}};
+        for (const auto &configuration: configurations) {
+            configuration_names.push_back(configuration.weather_map);
+        }
+
+        const auto renderer = offline_renderer_t{
+            camera,
+            cumulative_time,
+            cfg_value,
+            gpu_timer,
+            configuration_names,
+            take_parameter_snapshot,
+            apply_parameter_snapshot,
+            update_render_targets,
+            render_frame,
+            tonemap_pass,
+            [&]() -> const framebuffer_t & { return *framebuffer2; }};
+        if (!command_line->benchmark_path.empty()) {
+            run_benchmark(renderer, *command_line);
+        } else if (!command_line->sweep_directory.empty()) {
+            run_quality_sweep(renderer, *command_line);
+        } else {
+            run_headless(renderer, *command_line, replay);
+            export_gpu_timings((std::filesystem::path{command_line->output_directory} / gpu_timings_path).string());
+        }
+        export_trace();
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return 0;
+    }
+
+    auto recorder{std::unique_ptr<recorder_t>{}};
+    if (!command_line->record_path.empty()) {
+        recorder = std::make_unique<recorder_t>(command_line->record_path);
+        if (!recorder->is_open()) {
+            std::cerr << "cannot write " << command_line->record_path << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    while (glfwWindowShouldClose(window) == 0) {
+        const auto zone = profile_zone_t{"frame"};
+        {
+            const auto poll_zone = profile_zone_t{"poll events"};
+            glfwPollEvents();
+        }
+
+        // a minimized window has no framebuffer to render into
+        auto window_width{0};
+        auto window_height{0};
+        glfwGetFramebufferSize(window, &window_width, &window_height);
+        if (window_width == 0 || window_height == 0) {
+            glfwWaitEvents();
+            continue;
+        }
+        if (window_width != screen_width || window_height != screen_height) {
+            screen_width      = window_width;
+            screen_height     = window_height;
+            camera.projection = perspective(90.0F, static_cast<float>(screen_width) / screen_height, 0.01F, 100000.0F);
+        }
+
+        if (dynamic_resolution) {
+            render_scale = dynamic_resolution_controller.update(render_scale, gpu_timer.recent_mean("ray march", 8), ray_march_budget);
+        }
+        update_render_targets();
+
+        if (govern_quality) {
+            // gpu time of the whole frame, the sum of the passes of the last collected frame, passes which stopped
+            // running do not count, the patience of the governor smooths the noise of single frames
+            const auto &passes     = gpu_timer.last_frame();
+            const auto  frame_time = std::accumulate(passes.begin(), passes.end(), 0.0F);
+
+            auto quality = quality_t{primary_ray_steps, secondary_ray_steps, n};
+            if (quality_governor.update(quality, frame_time, frame_time_target)) {
+                primary_ray_steps   = quality.primary_ray_steps;
+                secondary_ray_steps = quality.secondary_ray_steps;
+                n                   = quality.octaves;
+            }
+        }
+
+        delta_time = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - now).count();
+        now        = std::chrono::high_resolution_clock::now();
+        cumulative_time += delta_time;
+
+        process_input(delta_time, camera);
+
+        //std::cout << "Delta time: " << delta_time << std::endl;
+
+        if (pending_report) {
+            const auto report_zone = profile_zone_t{"report"};
+            pending_report();
+            pending_report = nullptr;
+        }
+
+        if (recorder) {
+            recorder->record(cumulative_time, camera.transform.position, camera.transform.rotation, take_parameter_snapshot());
+        }
+
+        render_frame();
+
+        framebuffer_t::unbind();
+        tonemap_pass();
 
         // render gui
+        auto &cfg = configurations[cfg_value];
         if (options()) {
+            const auto imgui_zone = profile_zone_t{"imgui"};
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
@@ -348,17 +1522,64 @@ auto main() -> int
                         camera.transform.position.x,
                         camera.transform.position.y,
                         camera.transform.position.z);
-            ImGui::Text("press 'o' to toggle options");
+            for (auto i{std::size_t{}}; i < gpu_timer.passes().size(); i++) {
+                ImGui::Text("%s: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms",
+                            gpu_timer.passes()[i].c_str(),
+                            gpu_timer.percentile(i, 0.5F),
+                            gpu_timer.percentile(i, 0.95F),
+                            gpu_timer.percentile(i, 0.99F));
+            }
+            ImGui::Text("gpu timer stalls: %zu", gpu_timer.stalls());
+            if (govern_quality) {
+                ImGui::Text("quality governor: %d primary steps, %d secondary steps, %d octaves", primary_ray_steps, secondary_ray_steps, n);
+                for (const auto &decision: quality_governor.decisions()) {
+                    ImGui::Text("  %s", decision.c_str());
+                }
+            }
+            ImGui::Text("press 'o' to toggle options, 'p' to export gpu timings");
             ImGui::End();
 
             ImGui::Begin("options");
 
             ImGui::SliderInt("number of primary ray steps", &primary_ray_steps, 1, 500, "%d");
             ImGui::SliderInt("number of secondary ray steps", &secondary_ray_steps, 1, 100, "%d");
+            ImGui::Checkbox("quality governor", &govern_quality);
+            ImGui::SliderFloat("frame time target", &frame_time_target, 4.0F, 50.0F, "%.2f ms");
+            auto &bounds = quality_governor.bounds();
+            ImGui::DragIntRange2("governed primary ray steps", &bounds.min.primary_ray_steps, &bounds.max.primary_ray_steps, 1.0F, 1, 500);
+            ImGui::DragIntRange2("governed secondary ray steps", &bounds.min.secondary_ray_steps, &bounds.max.secondary_ray_steps, 1.0F, 1, 100);
+            ImGui::DragIntRange2("governed octaves", &bounds.min.octaves, &bounds.max.octaves, 1.0F, 1, 16);
             ImGui::NewLine();
 
             ImGui::RadioButton("low frequency noise", &radio_button_value, 2);
             ImGui::RadioButton("high frequency noise", &radio_button_value, 3);
+            ImGui::RadioButton("ray cost heatmap", &radio_button_value, ray_cost_heatmap);
+            if (radio_button_value == ray_cost_heatmap) {
+                constexpr auto counter_names = std::array{"primary steps", "secondary samples", "erosion fetches"};
+
+                // the totals count marched rays, a scaled down march spreads the cost of a ray over the pixels it covers
+                const auto &statistics = ray_cost->statistics();
+                if (temporal_reprojection) {
+                    ImGui::Text("temporal reprojection marches one pixel in %d, reprojected pixels cost nothing",
+                                temporal_block_size * temporal_block_size);
+                }
+                for (auto i{0}; i < static_cast<std::int32_t>(counter_names.size()); i++) {
+                    ImGui::RadioButton(counter_names[i], &heatmap_counter, i);
+                    ImGui::SameLine();
+                    ImGui::Text("total %llu, %.1f per marched pixel",
+                                static_cast<unsigned long long>(statistics.totals[i]),
+                                statistics.pixels == 0 ? 0.0F : static_cast<float>(statistics.totals[i]) / statistics.pixels);
+                    ImGui::PlotHistogram((std::string{"##"} + counter_names[i]).c_str(),
+                                         statistics.histograms[i].data(),
+                                         static_cast<int>(ray_cost_t::histogram_bins),
+                                         0,
+                                         "log2 bins",
+                                         0.0F,
+                                         FLT_MAX,
+                                         ImVec2{0.0F, 60.0F});
+                }
+                ImGui::SliderFloat("heatmap max cost", &heatmap_max_cost, 1.0F, 4096.0F, "%.0f");
+            }
             ImGui::NewLine();
 
             ImGui::RadioButton("cumulus map", &cfg_value, 0);
@@ -369,6 +1590,120 @@ auto main() -> int
 
             ImGui::Checkbox("blue noise jitter", &blue_noise);
             ImGui::Checkbox("gaussian blur", &blur);
+            ImGui::SliderInt("blur radius", &blur_radius, 1, blur_chain_t::max_radius, "%d");
+            ImGui::SliderInt("blur downsample levels", &blur_downsample_levels, 0, 4, "%d");
+            ImGui::Checkbox("denoiser", &denoise);
+            ImGui::SliderInt("denoiser iterations", &denoise_iterations, 1, 5, "%d");
+            ImGui::SliderFloat("denoiser depth sigma", &denoise_depth_sigma, 0.01F, 1.0F, "%.3f");
+            ImGui::SliderFloat("denoiser transmittance sigma", &denoise_transmittance_sigma, 0.01F, 1.0F, "%.3f");
+            ImGui::SliderFloat("denoiser luminance sigma", &denoise_luminance_sigma, 0.01F, 4.0F, "%.3f");
+            ImGui::NewLine();
+
+            ImGui::RadioButton("full resolution", &resolution_scale, 1);
+            ImGui::RadioButton("half resolution", &resolution_scale, 2);
+            ImGui::RadioButton("quarter resolution", &resolution_scale, 4);
+            ImGui::Checkbox("dynamic resolution", &dynamic_resolution);
+            ImGui::SliderFloat("ray march budget", &ray_march_budget, 1.0F, 33.0F, "%.1f ms");
+            ImGui::SliderFloat("render scale", &render_scale, 0.25F, 1.0F, "%.2f");
+            ImGui::Text("render resolution: %ux%u", framebuffer2->width(), framebuffer2->height());
+            ImGui::Checkbox("temporal reprojection", &temporal_reprojection);
+            ImGui::Checkbox("progressive refinement", &progressive);
+            ImGui::Checkbox("raise steps while refining", &progressive_raise_steps);
+            ImGui::SliderInt("refinement frames", &progressive_max_frames, 1, 1024, "%d");
+            if (progressive) {
+                ImGui::Text("accumulated frames: %u", accumulator->frames());
+            }
+            ImGui::Checkbox("adaptive step size", &adaptive_step_size);
+            ImGui::Checkbox("empty space skipping", &empty_space_skipping);
+            ImGui::Checkbox("cached sun transmittance", &use_light_volume);
+            ImGui::Checkbox("multiple scattering lut", &use_multiple_scattering_lut);
+            ImGui::Checkbox("cone light march", &cone_light_march);
+            ImGui::SliderInt("cone light steps", &cone_light_steps, 1, 8, "%d");
+            ImGui::SliderFloat("cone spread", &cone_spread, 0.0F, 0.5F, "%.3f");
+            ImGui::Text("light volume memory: %.2f MiB", static_cast<float>(light_volume.size_in_bytes()) / (1024.0F * 1024.0F));
+            ImGui::Checkbox("baked density", &use_density_volume);
+            for (auto i{std::size_t{}}; i < density_volume_resolutions.size(); i++) {
+                const auto &[width, height, depth] = density_volume_resolutions[i];
+                const auto label                   = std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(depth);
+                if (ImGui::RadioButton(label.c_str(), density_volume_resolution == i)) {
+                    density_volume_resolution = i;
+                }
+            }
+            if (density_volume) {
+                ImGui::Text("density volume memory: %.2f MiB", static_cast<float>(density_volume->size_in_bytes()) / (1024.0F * 1024.0F));
+            }
+            ImGui::SliderInt("volume slices per frame", &volume_slices_per_frame, 1, 128, "%d");
+            ImGui::Checkbox("sparse baked density", &use_brick_pool);
+            ImGui::Checkbox("density bounds skipping", &density_bounds_skipping);
+            ImGui::Checkbox("height profile lut", &use_height_profile);
+            ImGui::Checkbox("compute ray marcher", &compute_ray_marching);
+            ImGui::SliderInt("compute segment steps", &compute_segment_steps, 4, 64, "%d");
+            ImGui::Checkbox("detail lod", &detail_lod);
+            ImGui::SliderFloat("erosion fade start", &erosion_fade_start, 0.0F, 60000.0F, "%.0f m");
+            ImGui::SliderFloat("erosion fade end", &erosion_fade_end, 0.0F, 60000.0F, "%.0f m");
+            if (brick_pool.valid()) {
+                ImGui::Text("brick pool: %u/%u bricks, %.2f MiB",
+                            brick_pool.allocated_bricks(),
+                            brick_pool.total_bricks(),
+                            static_cast<float>(brick_pool.size_in_bytes()) / (1024.0F * 1024.0F));
+            }
+            ImGui::NewLine();
+
+            if (ImGui::Button("measure resolution scales")) {
+                pending_report = report_resolution_scales;
+            }
+            if (ImGui::Button("compare adaptive step size")) {
+                pending_report = [&] { report_option("adaptive step size", adaptive_step_size); };
+            }
+            if (ImGui::Button("compare empty space skipping")) {
+                pending_report = [&] { report_option("empty space skipping", empty_space_skipping); };
+            }
+            if (ImGui::Button("compare multiple scattering lut")) {
+                pending_report = [&] { report_option("multiple scattering lut", use_multiple_scattering_lut); };
+            }
+            if (ImGui::Button("compare cone light march")) {
+                pending_report = [&] { report_option("cone light march", cone_light_march); };
+            }
+            if (ImGui::Button("compare cached sun transmittance")) {
+                pending_report = report_light_volume;
+            }
+            if (ImGui::Button("compare density volume resolutions")) {
+                pending_report = report_density_volume;
+            }
+            if (ImGui::Button("compare density bounds skipping")) {
+                pending_report = [&] {
+                    build_density_bounds();
+                    report_option("density bounds skipping", density_bounds_skipping);
+                };
+            }
+            if (ImGui::Button("compare height profile lut")) {
+                pending_report = [&] { report_option("height profile lut", use_height_profile); };
+            }
+            if (ImGui::Button("compare compute ray marcher")) {
+                pending_report = [&] { report_option("compute ray marcher", compute_ray_marching); };
+            }
+            if (ImGui::Button("compare denoiser")) {
+                pending_report = report_denoiser;
+            }
+            if (ImGui::Button("compare detail lod")) {
+                pending_report = report_detail_lod;
+            }
+            if (ImGui::Button("measure brick pool")) {
+                pending_report = report_brick_pool;
+            }
+            if (ImGui::Button("compare sparse baked density")) {
+                pending_report = [&] {
+                    build_brick_pool();
+                    report_option("sparse baked density", use_brick_pool);
+                };
+            }
+            for (const auto &report: reports) {
+                ImGui::Text("%s: %.2f ms, rmse %.5f, %.1f samples per pixel", report.name.c_str(), report.frame_time, report.error, report.samples_per_pixel);
+                if (report.shimmer > 0.0F) {
+                    ImGui::SameLine();
+                    ImGui::Text(", shimmer %.5f", report.shimmer);
+                }
+            }
             ImGui::NewLine();
 
             ImGui::SliderFloat("low frequency noise scale", &cfg.base_scale, 10.0F, 200000.0F, "%.5f");
@@ -402,13 +1737,24 @@ auto main() -> int
             ImGui::SliderFloat("eccentricity attenuation", &cfg.c, 0.01F, 1.0F, "%.2f");
             ImGui::End();
 
+            gpu_timer.begin("imgui");
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            gpu_timer.end();
         }
 
+        gpu_timer.next_frame();
+        if (consume_export_request()) {
+            export_gpu_timings(gpu_timings_path);
+        }
+
+        const auto swap_zone = profile_zone_t{"swap buffers"};
         glfwSwapBuffers(window);
     }
 
+    export_gpu_timings(gpu_timings_path);
+    export_trace();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
 
@@ -0,0 +1,49 @@
+#include "multiple_scattering_lut.hpp"
+
+#include <glbinding/gl/functions.h>
+
+multiple_scattering_lut_t::multiple_scattering_lut_t(std::uint32_t width, std::uint32_t height) noexcept
+    : width_{width}
+    , height_{height}
+    , texture_{width,
+               height,
+               0,
+               nullptr,
+               gl::GLenum::GL_RGBA16F,
+               gl::GLenum::GL_RGBA,
+               gl::GLenum::GL_FLOAT,
+               gl::GLenum::GL_LINEAR,
+               gl::GLenum::GL_LINEAR,
+               gl::GLenum::GL_CLAMP_TO_EDGE,
+               gl::GLenum::GL_CLAMP_TO_EDGE}
+{
+}
+
+auto multiple_scattering_lut_t::update(const shader_t &shader, const texture_t<1U> &mie_texture, float a, float b, float c, std::int32_t n) noexcept -> void
+{
+    if (a == a_ && b == b_ && c == c_ && n == n_) {
+        return;
+    }
+
+    a_ = a;
+    b_ = b;
+    c_ = c;
+    n_ = n;
+
+    shader.use();
+    mie_texture.bind(0);
+    shader.set_uniform("mie_texture", 0);
+    shader.set_uniform("N", n);
+    shader.set_uniform("a", a);
+    shader.set_uniform("b", b);
+    shader.set_uniform("c", c);
+
+    gl::glBindImageTexture(0, texture_.id(), 0, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA16F);
+    gl::glDispatchCompute((width_ + 7) / 8, (height_ + 7) / 8, 1);
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+auto multiple_scattering_lut_t::bind(std::int32_t unit) const noexcept -> void
+{
+    texture_.bind(unit);
+}
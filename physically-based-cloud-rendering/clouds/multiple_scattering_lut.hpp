@@ -0,0 +1,25 @@
+#pragma once
+
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <cstdint>
+
+// octave sum of the multiple scattering approximation over transmittance and scattering angle
+class multiple_scattering_lut_t {
+public:
+    multiple_scattering_lut_t(std::uint32_t width, std::uint32_t height) noexcept;
+
+    // regenerates the table with multiple_scattering.comp when the octave parameters change
+    auto update(const shader_t &shader, const texture_t<1U> &mie_texture, float a, float b, float c, std::int32_t n) noexcept -> void;
+    auto bind(std::int32_t unit = -1) const noexcept -> void;
+
+private:
+    std::uint32_t width_{};
+    std::uint32_t height_{};
+    texture_t<2U> texture_{};
+    float         a_{-1.0F};
+    float         b_{-1.0F};
+    float         c_{-1.0F};
+    std::int32_t  n_{-1};
+};
@@ -0,0 +1,90 @@
+#include "occupancy_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glbinding/gl/functions.h>
+
+occupancy_map_t::occupancy_map_t(const texture_t<2U> &weather_map, std::uint32_t size) noexcept
+    : size_{size}
+    , weather_data_(static_cast<std::size_t>(size) * size * 4)
+    , texture_{size, size, 0, nullptr, gl::GLenum::GL_R32F, gl::GLenum::GL_RED, gl::GLenum::GL_FLOAT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST_MIPMAP_NEAREST}
+{
+    weather_map.bind();
+    gl::glGetTexImage(gl::GLenum::GL_TEXTURE_2D, 0, gl::GLenum::GL_RGBA, gl::GLenum::GL_UNSIGNED_BYTE, weather_data_.data());
+}
+
+auto occupancy_map_t::update(float global_coverage, float coverage_multiplier) noexcept -> void
+{
+    if (global_coverage == global_coverage_ && coverage_multiplier == coverage_multiplier_) {
+        return;
+    }
+
+    global_coverage_     = global_coverage;
+    coverage_multiplier_ = coverage_multiplier;
+
+    // same coverage as get_coverage() in raymarch.frag without the height term
+    auto coverage{std::vector<float>(static_cast<std::size_t>(size_) * size_)};
+    for (auto i{std::size_t{}}; i < coverage.size(); i++) {
+        const auto x = weather_data_[4 * i] / 255.0F;
+        const auto y = weather_data_[4 * i + 1] / 255.0F;
+        coverage[i]  = (x + (y - x) * global_coverage) * coverage_multiplier;
+    }
+
+    // the weather map is sampled bilinearly with repeat wrapping, so the base level
+    // is dilated by one texel to stay conservative
+    auto level{std::vector<float>(coverage.size())};
+    for (auto y{std::uint32_t{}}; y < size_; y++) {
+        for (auto x{std::uint32_t{}}; x < size_; x++) {
+            auto maximum{0.0F};
+            for (auto dy{-1}; dy <= 1; dy++) {
+                for (auto dx{-1}; dx <= 1; dx++) {
+                    const auto sx = (x + size_ + dx) % size_;
+                    const auto sy = (y + size_ + dy) % size_;
+                    maximum       = std::max(maximum, coverage[static_cast<std::size_t>(sy) * size_ + sx]);
+                }
+            }
+            level[static_cast<std::size_t>(y) * size_ + x] = maximum;
+        }
+    }
+
+    texture_.bind();
+    auto level_size{size_};
+    for (auto i{0}; i < levels(); i++) {
+        glTexSubImage2D(gl::GLenum::GL_TEXTURE_2D,
+                        i,
+                        0,
+                        0,
+                        static_cast<gl::GLsizei>(level_size),
+                        static_cast<gl::GLsizei>(level_size),
+                        gl::GLenum::GL_RED,
+                        gl::GLenum::GL_FLOAT,
+                        level.data());
+
+        const auto next_size = std::max(level_size / 2, 1U);
+        auto       next{std::vector<float>(static_cast<std::size_t>(next_size) * next_size)};
+        for (auto y{std::uint32_t{}}; y < next_size; y++) {
+            for (auto x{std::uint32_t{}}; x < next_size; x++) {
+                const auto sx = std::min(2 * x + 1, level_size - 1);
+                const auto sy = std::min(2 * y + 1, level_size - 1);
+
+                next[static_cast<std::size_t>(y) * next_size + x] = std::max({level[static_cast<std::size_t>(2 * y) * level_size + 2 * x],
+                                                                               level[static_cast<std::size_t>(2 * y) * level_size + sx],
+                                                                               level[static_cast<std::size_t>(sy) * level_size + 2 * x],
+                                                                               level[static_cast<std::size_t>(sy) * level_size + sx]});
+            }
+        }
+
+        level      = std::move(next);
+        level_size = next_size;
+    }
+}
+
+auto occupancy_map_t::bind(std::int32_t unit) const noexcept -> void
+{
+    texture_.bind(unit);
+}
+
+auto occupancy_map_t::levels() const noexcept -> std::int32_t
+{
+    return static_cast<std::int32_t>(std::floor(std::log2(size_))) + 1;
+}
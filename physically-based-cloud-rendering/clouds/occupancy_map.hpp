@@ -0,0 +1,26 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// max coverage pyramid of a weather map, a zero texel at any level guarantees
+// there is no cloud above its footprint
+class occupancy_map_t {
+public:
+    occupancy_map_t(const texture_t<2U> &weather_map, std::uint32_t size) noexcept;
+
+    // rebuilds the pyramid when the coverage parameters change
+    auto update(float global_coverage, float coverage_multiplier) noexcept -> void;
+    auto bind(std::int32_t unit = -1) const noexcept -> void;
+
+    [[nodiscard]] auto levels() const noexcept -> std::int32_t;
+
+private:
+    std::uint32_t             size_{};
+    std::vector<std::uint8_t> weather_data_{};
+    texture_t<2U>             texture_{};
+    float                     global_coverage_{-1.0F};
+    float                     coverage_multiplier_{-1.0F};
+};
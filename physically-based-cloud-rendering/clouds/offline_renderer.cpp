@@ -0,0 +1,18 @@
+#include "offline_renderer.hpp"
+
+auto set_camera_pose(camera_t &camera, const camera_pose_t &pose) noexcept -> void
+{
+    camera.transform.position = glm::vec4{pose.position, 1.0F};
+    camera.transform.rotation = glm::vec3{pose.pitch, pose.yaw, 0.0F};
+}
+
+auto render_timed_frame(const offline_renderer_t &renderer, const framebuffer_t *output) -> void
+{
+    renderer.render_clouds();
+    if (output != nullptr) {
+        output->bind();
+        renderer.tonemap();
+    }
+    renderer.gpu_timer.flush();
+    renderer.gpu_timer.next_frame();
+}
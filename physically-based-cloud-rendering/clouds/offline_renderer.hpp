@@ -0,0 +1,43 @@
+#pragma once
+
+#include "camera.hpp"
+#include "command_line.hpp"
+#include "framebuffer.hpp"
+#include "gpu_timer.hpp"
+#include "recording.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// the parts of the viewer the benchmark, the quality sweep and headless runs drive, main owns the options
+// and the render targets, the callbacks render with whatever the options are set to
+struct offline_renderer_t {
+    camera_t                     &camera;
+    // animation time of the clouds in milliseconds
+    float                        &time;
+    // index into configurations, switching it keeps the fields of every configuration as they are
+    std::int32_t                 &configuration;
+    gpu_timer_t                  &gpu_timer;
+    // weather map of every built-in configuration
+    std::vector<std::string_view> configurations{};
+
+    // every option of the viewer and every field of the active configuration, see parameter_snapshot_t
+    std::function<parameter_snapshot_t()>     take_parameters{};
+    std::function<void(parameter_snapshot_t)> apply_parameters{};
+    // reallocates the render targets after the screen size or the render scale changed
+    std::function<void()>                     update_render_targets{};
+    // every pass up to the hdr image of the clouds
+    std::function<void()>                     render_clouds{};
+    // tonemaps the clouds into the bound framebuffer of the screen size
+    std::function<void()>                     tonemap{};
+    // render target of the hdr image of the clouds
+    std::function<const framebuffer_t &()>    clouds{};
+};
+
+auto set_camera_pose(camera_t &camera, const camera_pose_t &pose) noexcept -> void;
+
+// renders a frame, tonemaps it into output unless it is null and waits for the gpu, afterwards
+// gpu_timer.last_frame() holds the passes of this frame
+auto render_timed_frame(const offline_renderer_t &renderer, const framebuffer_t *output) -> void;
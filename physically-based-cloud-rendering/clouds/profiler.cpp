@@ -0,0 +1,144 @@
+#include "profiler.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+
+namespace {
+constexpr auto events_per_thread = std::size_t{1} << 18U;
+// gpu zones get their own track in the trace
+constexpr auto gpu_thread = 0U;
+
+struct trace_event_t {
+    const char * name{};
+    const char * detail{};
+    std::int64_t begin{};
+    std::int64_t duration{};
+    bool         gpu{};
+};
+
+// written only by its thread, count is published after the event so the writer never reads a partial event
+struct thread_buffer_t {
+    std::unique_ptr<std::array<trace_event_t, events_per_thread>> events{std::make_unique<std::array<trace_event_t, events_per_thread>>()};
+    std::atomic<std::size_t>                                      count{};
+    std::uint32_t                                                 thread{};
+    thread_buffer_t *                                             next{};
+};
+
+auto tracing{std::atomic<bool>{false}};
+auto buffers{std::atomic<thread_buffer_t *>{nullptr}};
+auto next_thread{std::atomic<std::uint32_t>{gpu_thread + 1}};
+
+// buffers are linked into the list once and never freed, threads may end before the trace is written
+auto get_thread_buffer() -> thread_buffer_t &
+{
+    thread_local auto *buffer = [] {
+        auto *created   = new thread_buffer_t{};
+        created->thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+        created->next   = buffers.load(std::memory_order_relaxed);
+        while (!buffers.compare_exchange_weak(created->next, created, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return created;
+    }();
+
+    return *buffer;
+}
+
+auto record(const trace_event_t &event) -> void
+{
+    auto      &buffer = get_thread_buffer();
+    const auto index  = buffer.count.load(std::memory_order_relaxed);
+    if (index == events_per_thread) {
+        return;
+    }
+
+    (*buffer.events)[index] = event;
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+auto write_escaped(std::ofstream &file, const char *text) -> void
+{
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\') {
+            file << '\\';
+        }
+        file << *text;
+    }
+}
+} // namespace
+
+auto enable_tracing() noexcept -> void
+{
+    tracing.store(true, std::memory_order_relaxed);
+}
+
+auto tracing_enabled() noexcept -> bool
+{
+    return tracing.load(std::memory_order_relaxed);
+}
+
+auto profiler_now() noexcept -> std::int64_t
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto record_gpu_zone(const char *name, std::int64_t begin, std::int64_t duration) noexcept -> void
+{
+    if (tracing_enabled()) {
+        record({name, nullptr, begin, duration, true});
+    }
+}
+
+auto write_trace(const std::string &path) -> bool
+{
+    auto file{std::ofstream{path}};
+    if (!file) {
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << gpu_thread << R"(,"args":{"name":"gpu"}})";
+
+    for (auto *buffer = buffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        file << ",\n"
+             << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->thread << R"(,"args":{"name":"cpu thread )" << buffer->thread
+             << "\"}}";
+
+        const auto count = buffer->count.load(std::memory_order_acquire);
+        for (auto i{std::size_t{}}; i < count; i++) {
+            const auto &event = (*buffer->events)[i];
+
+            file << ",\n{\"name\":\"";
+            write_escaped(file, event.name);
+            file << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu") << R"(","ph":"X","pid":1,"tid":)"
+                 << (event.gpu ? gpu_thread : buffer->thread) << ",\"ts\":" << static_cast<double>(event.begin) / 1000.0
+                 << ",\"dur\":" << static_cast<double>(event.duration) / 1000.0;
+            if (event.detail != nullptr) {
+                file << ",\"args\":{\"detail\":\"";
+                write_escaped(file, event.detail);
+                file << "\"}";
+            }
+            file << '}';
+        }
+    }
+
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+profile_zone_t::profile_zone_t(const char *name, const char *detail) noexcept
+    : name_{name}
+    , detail_{detail}
+    , begin_{profiler_now()}
+{
+}
+
+profile_zone_t::~profile_zone_t() noexcept
+{
+    if (tracing_enabled()) {
+        record({name_, detail_, begin_, profiler_now() - begin_, false});
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// cpu zones and gpu pass times on one timeline, written as chrome trace event json (chrome://tracing,
+// perfetto), every thread records into its own buffer without locks, names and details have to outlive
+// the trace, string literals do
+
+// recording is off until this is called, zones cost one clock read when it is off
+auto enable_tracing() noexcept -> void;
+[[nodiscard]] auto tracing_enabled() noexcept -> bool;
+// nanoseconds of the steady clock since the first call
+[[nodiscard]] auto profiler_now() noexcept -> std::int64_t;
+// a gpu zone with its start already converted to profiler_now() time
+auto record_gpu_zone(const char *name, std::int64_t begin, std::int64_t duration) noexcept -> void;
+// zones recorded so far by every thread
+auto write_trace(const std::string &path) -> bool;
+
+class profile_zone_t {
+public:
+    explicit profile_zone_t(const char *name, const char *detail = nullptr) noexcept;
+    profile_zone_t(const profile_zone_t &) = delete;
+    profile_zone_t(profile_zone_t &&)      = delete; // YAGNI
+    auto operator=(const profile_zone_t &) = delete;
+    auto operator=(profile_zone_t &&) = delete; // YAGNI
+    ~profile_zone_t() noexcept;
+
+private:
+    const char * name_{};
+    const char * detail_{};
+    std::int64_t begin_{};
+};
@@ -0,0 +1,106 @@
+#include "quality_governor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+// moves a step count by about 10% and at least by one
+auto step(std::int32_t value, bool raise, std::int32_t min, std::int32_t max) noexcept -> std::int32_t
+{
+    const auto delta = std::max(value / 10, 1);
+    return std::clamp(raise ? value + delta : value - delta, min, std::max(min, max));
+}
+
+auto describe(const char *name, std::int32_t from, std::int32_t to) -> std::string
+{
+    return std::string{name} + " " + std::to_string(from) + " -> " + std::to_string(to);
+}
+} // namespace
+
+quality_governor_t::quality_governor_t(const bounds_t &bounds) noexcept
+    : bounds_{bounds}
+{
+}
+
+auto quality_governor_t::update(quality_t &quality, float frame_time, float target) -> bool
+{
+    frame_++;
+    if (frames_since_change_ < settle_frames) {
+        frames_since_change_++;
+        return false;
+    }
+    if (frame_time <= 0.0F || target <= 0.0F) {
+        return false;
+    }
+
+    frames_over_  = frame_time > target * lower_threshold ? frames_over_ + 1 : 0;
+    frames_under_ = frame_time < target * raise_threshold ? frames_under_ + 1 : 0;
+
+    const auto &min = bounds_.min;
+    const auto &max = bounds_.max;
+
+    // over the target the octaves go first, then the light march and then the view ray, which costs
+    // the most image quality, raising restores them in the opposite order
+    auto decision{std::string{}};
+    if (frames_over_ >= patience) {
+        if (const auto octaves = step(quality.octaves, false, min.octaves, max.octaves); octaves < quality.octaves) {
+            decision        = describe("octaves", quality.octaves, octaves);
+            quality.octaves = octaves;
+        } else if (const auto steps = step(quality.secondary_ray_steps, false, min.secondary_ray_steps, max.secondary_ray_steps);
+                   steps < quality.secondary_ray_steps) {
+            decision                    = describe("secondary ray steps", quality.secondary_ray_steps, steps);
+            quality.secondary_ray_steps = steps;
+        } else if (const auto steps = step(quality.primary_ray_steps, false, min.primary_ray_steps, max.primary_ray_steps);
+                   steps < quality.primary_ray_steps) {
+            decision                  = describe("primary ray steps", quality.primary_ray_steps, steps);
+            quality.primary_ray_steps = steps;
+        }
+    } else if (frames_under_ >= patience) {
+        if (const auto steps = step(quality.primary_ray_steps, true, min.primary_ray_steps, max.primary_ray_steps);
+            steps > quality.primary_ray_steps) {
+            decision                  = describe("primary ray steps", quality.primary_ray_steps, steps);
+            quality.primary_ray_steps = steps;
+        } else if (const auto steps = step(quality.secondary_ray_steps, true, min.secondary_ray_steps, max.secondary_ray_steps);
+                   steps > quality.secondary_ray_steps) {
+            decision                    = describe("secondary ray steps", quality.secondary_ray_steps, steps);
+            quality.secondary_ray_steps = steps;
+        } else if (const auto octaves = step(quality.octaves, true, min.octaves, max.octaves); octaves > quality.octaves) {
+            decision        = describe("octaves", quality.octaves, octaves);
+            quality.octaves = octaves;
+        }
+    }
+
+    if (decision.empty()) {
+        return false;
+    }
+
+    decide(decision, frame_time, target);
+    frames_over_         = 0;
+    frames_under_        = 0;
+    frames_since_change_ = 0;
+    return true;
+}
+
+auto quality_governor_t::bounds() noexcept -> bounds_t &
+{
+    return bounds_;
+}
+
+auto quality_governor_t::decisions() const noexcept -> const std::deque<std::string> &
+{
+    return decisions_;
+}
+
+auto quality_governor_t::decide(const std::string &decision, float frame_time, float target) -> void
+{
+    auto times{std::array<char, 64>{}};
+    std::snprintf(times.data(), times.size(), "%.2f ms for %.2f ms", frame_time, target);
+
+    decisions_.push_front("frame " + std::to_string(frame_) + ": " + times.data() + ", " + decision);
+    if (decisions_.size() > kept_decisions) {
+        decisions_.pop_back();
+    }
+    std::cout << "quality governor, " << decisions_.front() << std::endl;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// step counts and multiple scattering octaves of the ray marcher
+struct quality_t {
+    std::int32_t primary_ray_steps{};
+    std::int32_t secondary_ray_steps{};
+    std::int32_t octaves{};
+};
+
+// lowers and raises the quality to keep the gpu frame time near a target, a change needs the time to stay
+// outside a band around the target for a number of frames and is followed by a pause so the timings of
+// the new settings arrive first, the band is wider below the target than above it so a raise that lands
+// just over the target is not undone right away
+class quality_governor_t {
+public:
+    struct bounds_t {
+        quality_t min{};
+        quality_t max{};
+    };
+
+    explicit quality_governor_t(const bounds_t &bounds) noexcept;
+
+    // frame time and target in milliseconds, returns true when quality was changed, a time of 0
+    // (no timings yet) changes nothing
+    auto update(quality_t &quality, float frame_time, float target) -> bool;
+
+    [[nodiscard]] auto bounds() noexcept -> bounds_t &;
+    // most recent decision first
+    [[nodiscard]] auto decisions() const noexcept -> const std::deque<std::string> &;
+
+private:
+    static constexpr auto lower_threshold = 1.05F;
+    static constexpr auto raise_threshold = 0.85F;
+    static constexpr auto patience        = 8;
+    static constexpr auto settle_frames   = 16;
+    static constexpr auto kept_decisions  = 8U;
+
+    auto decide(const std::string &decision, float frame_time, float target) -> void;
+
+    bounds_t                bounds_{};
+    std::int32_t            frames_over_{};
+    std::int32_t            frames_under_{};
+    std::int32_t            frames_since_change_{};
+    std::uint64_t           frame_{};
+    std::deque<std::string> decisions_{};
+};
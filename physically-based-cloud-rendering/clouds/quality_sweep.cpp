@@ -0,0 +1,254 @@
+#include "quality_sweep.hpp"
+
+#include "benchmark.hpp"
+#include "image_metrics.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <numeric>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+namespace {
+// a metric where larger is better, colour difference is negated
+using metric_t = std::function<float(const image_quality_t &)>;
+
+// walks the settings from the cheapest up and keeps every one that improves on the best metric so far
+auto pareto_front(const std::vector<sweep_result_t> &results, const metric_t &metric) -> std::vector<std::size_t>
+{
+    auto order{std::vector<std::size_t>(results.size())};
+    std::iota(order.begin(), order.end(), std::size_t{});
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (results[a].frame_time != results[b].frame_time) {
+            return results[a].frame_time < results[b].frame_time;
+        }
+        return metric(results[a].quality) > metric(results[b].quality);
+    });
+
+    auto front{std::vector<std::size_t>{}};
+    for (const auto index: order) {
+        if (front.empty() || metric(results[index].quality) > metric(results[front.back()].quality)) {
+            front.push_back(index);
+        }
+    }
+
+    return front;
+}
+
+auto describe(const sweep_setting_t &setting) -> std::string
+{
+    auto text{std::array<char, 96>{}};
+    std::snprintf(text.data(),
+                  text.size(),
+                  "%3d primary, %2d secondary, blur %-3s, blue noise %-3s",
+                  setting.primary_ray_steps,
+                  setting.secondary_ray_steps,
+                  setting.blur ? "on" : "off",
+                  setting.blue_noise ? "on" : "off");
+    return text.data();
+}
+} // namespace
+
+auto sweep_settings() -> std::vector<sweep_setting_t>
+{
+    constexpr auto primary_ray_steps   = std::array{32, 48, 64, 96, 128, 192, 256};
+    constexpr auto secondary_ray_steps = std::array{4, 8, 16, 32};
+
+    auto settings{std::vector<sweep_setting_t>{}};
+    for (const auto primary: primary_ray_steps) {
+        for (const auto secondary: secondary_ray_steps) {
+            for (const auto blur: {false, true}) {
+                for (const auto blue_noise: {false, true}) {
+                    settings.push_back(sweep_setting_t{primary, secondary, blur, blue_noise});
+                }
+            }
+        }
+    }
+
+    return settings;
+}
+
+auto measure_image_quality(const std::vector<float> &image,
+                           const std::vector<float> &reference,
+                           std::uint32_t             width,
+                           std::uint32_t             height,
+                           float                     exposure_factor) -> image_quality_t
+{
+    return image_quality_t{peak_signal_to_noise_ratio(image, reference, exposure_factor),
+                           structural_similarity(image, reference, width, height, exposure_factor),
+                           mean_colour_difference(image, reference, exposure_factor)};
+}
+
+auto mark_pareto_fronts(std::vector<sweep_result_t> &results) -> void
+{
+    for (const auto index: pareto_front(results, [](const image_quality_t &quality) { return quality.psnr; })) {
+        results[index].pareto_psnr = true;
+    }
+    for (const auto index: pareto_front(results, [](const image_quality_t &quality) { return quality.ssim; })) {
+        results[index].pareto_ssim = true;
+    }
+    for (const auto index: pareto_front(results, [](const image_quality_t &quality) { return -quality.colour_difference; })) {
+        results[index].pareto_colour_difference = true;
+    }
+}
+
+auto write_sweep_csv(const std::string &path, const std::vector<sweep_result_t> &results) -> bool
+{
+    auto file{std::ofstream{path}};
+    if (!file) {
+        return false;
+    }
+
+    file << "primary_ray_steps,secondary_ray_steps,blur,blue_noise,frame_ms,psnr_db,ssim,colour_difference,pareto_psnr,pareto_ssim,"
+            "pareto_colour_difference\n";
+    for (const auto &result: results) {
+        const auto &setting = result.setting;
+        file << setting.primary_ray_steps << ',' << setting.secondary_ray_steps << ',' << setting.blur << ',' << setting.blue_noise << ','
+             << result.frame_time << ',' << result.quality.psnr << ',' << result.quality.ssim << ',' << result.quality.colour_difference << ','
+             << result.pareto_psnr << ',' << result.pareto_ssim << ',' << result.pareto_colour_difference << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+auto write_pareto_table(std::ostream &stream, const std::vector<sweep_result_t> &results) -> void
+{
+    const auto fronts = std::array{
+        std::pair{"psnr", &sweep_result_t::pareto_psnr},
+        std::pair{"ssim", &sweep_result_t::pareto_ssim},
+        std::pair{"colour difference", &sweep_result_t::pareto_colour_difference}};
+
+    for (const auto &[name, on_front]: fronts) {
+        auto front{std::vector<const sweep_result_t *>{}};
+        for (const auto &result: results) {
+            if (result.*on_front) {
+                front.push_back(&result);
+            }
+        }
+        std::sort(front.begin(), front.end(), [](const auto *a, const auto *b) { return a->frame_time < b->frame_time; });
+
+        stream << "pareto front of frame time against " << name << '\n';
+        for (const auto *result: front) {
+            auto line{std::array<char, 192>{}};
+            std::snprintf(line.data(),
+                          line.size(),
+                          "  %s: %8.3f ms, psnr %6.2f db, ssim %.4f, colour difference %.3f\n",
+                          describe(result->setting).c_str(),
+                          result->frame_time,
+                          result->quality.psnr,
+                          result->quality.ssim,
+                          result->quality.colour_difference);
+            stream << line.data();
+        }
+    }
+}
+
+auto run_quality_sweep(const offline_renderer_t &renderer, const command_line_t &command_line) -> void
+{
+    constexpr auto reference_frames = 32;
+
+    const auto output_directory = std::filesystem::path{command_line.sweep_directory};
+    std::filesystem::create_directories(output_directory);
+
+    auto       parameters{renderer.take_parameters()};
+    const auto width    = renderer.clouds().width();
+    const auto height   = renderer.clouds().height();
+    const auto exposure = parameters.exposure_factor;
+
+    auto references{std::vector<std::vector<float>>{}};
+    parameters.primary_ray_steps      = 256;
+    parameters.secondary_ray_steps    = 32;
+    parameters.blur                   = false;
+    parameters.progressive            = true;
+    parameters.progressive_max_frames = reference_frames;
+    renderer.apply_parameters(parameters);
+    for (const auto &view: benchmark_views) {
+        const auto zone = profile_zone_t{"sweep reference", view.name.data()};
+        set_camera_pose(renderer.camera, view.pose);
+        for (auto frame{0}; frame < reference_frames; frame++) {
+            render_timed_frame(renderer, nullptr);
+        }
+        references.push_back(read_texture(renderer.clouds().colour_attachments().front(), width, height));
+        std::cout << "rendered the reference of the " << view.name << " view" << std::endl;
+    }
+    parameters.progressive = false;
+
+    const auto settings = sweep_settings();
+    const auto threads  = static_cast<std::size_t>(std::max(std::thread::hardware_concurrency(), 1U));
+
+    // one job per setting and view in that order, at most one per thread in flight so the images
+    // waiting for their metrics do not pile up
+    auto jobs{std::deque<std::future<image_quality_t>>{}};
+    auto waited{std::size_t{}};
+    auto results{std::vector<sweep_result_t>{}};
+    for (const auto &setting: settings) {
+        parameters.primary_ray_steps   = setting.primary_ray_steps;
+        parameters.secondary_ray_steps = setting.secondary_ray_steps;
+        parameters.blur                = setting.blur;
+        parameters.blue_noise          = setting.blue_noise;
+        renderer.apply_parameters(parameters);
+
+        auto frame_time{0.0F};
+        for (auto view{std::size_t{}}; view < benchmark_views.size(); view++) {
+            const auto zone = profile_zone_t{"sweep setting", benchmark_views[view].name.data()};
+            set_camera_pose(renderer.camera, benchmark_views[view].pose);
+            for (auto frame{0}; frame < command_line.warmup_frames + command_line.repetitions; frame++) {
+                render_timed_frame(renderer, nullptr);
+                if (frame >= command_line.warmup_frames) {
+                    const auto &passes = renderer.gpu_timer.last_frame();
+                    frame_time += std::accumulate(passes.begin(), passes.end(), 0.0F);
+                }
+            }
+
+            while (jobs.size() - waited >= threads) {
+                jobs[waited++].wait();
+            }
+            jobs.push_back(std::async(std::launch::async,
+                                      [&reference = references[view],
+                                       image      = read_texture(renderer.clouds().colour_attachments().front(), width, height),
+                                       width,
+                                       height,
+                                       exposure] { return measure_image_quality(image, reference, width, height, exposure); }));
+        }
+
+        results.push_back(sweep_result_t{setting, frame_time / static_cast<float>(benchmark_views.size() * command_line.repetitions), {}});
+        std::cout << "swept " << results.size() << "/" << settings.size() << " settings" << std::endl;
+    }
+
+    for (auto i{std::size_t{}}; i < results.size(); i++) {
+        auto &quality = results[i].quality;
+        for (auto view{std::size_t{}}; view < benchmark_views.size(); view++) {
+            const auto view_quality = jobs[i * benchmark_views.size() + view].get();
+            quality.psnr += view_quality.psnr / static_cast<float>(benchmark_views.size());
+            quality.ssim += view_quality.ssim / static_cast<float>(benchmark_views.size());
+            quality.colour_difference += view_quality.colour_difference / static_cast<float>(benchmark_views.size());
+        }
+    }
+    mark_pareto_fronts(results);
+
+    const auto csv_path = (output_directory / "sweep.csv").string();
+    if (write_sweep_csv(csv_path, results)) {
+        std::cout << "wrote " << csv_path << std::endl;
+    } else {
+        std::cerr << "cannot write " << csv_path << std::endl;
+    }
+
+    const auto table_path = (output_directory / "pareto.txt").string();
+    auto       table{std::ofstream{table_path}};
+    write_pareto_table(table, results);
+    write_pareto_table(std::cout, results);
+    if (table) {
+        std::cout << "wrote " << table_path << std::endl;
+    } else {
+        std::cerr << "cannot write " << table_path << std::endl;
+    }
+}
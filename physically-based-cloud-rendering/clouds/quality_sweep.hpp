@@ -0,0 +1,58 @@
+#pragma once
+
+#include "command_line.hpp"
+#include "offline_renderer.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// one combination of the swept quality parameters
+struct sweep_setting_t {
+    std::int32_t primary_ray_steps{};
+    std::int32_t secondary_ray_steps{};
+    bool         blur{};
+    bool         blue_noise{};
+};
+
+// error of an image against the reference of its view
+struct image_quality_t {
+    float psnr{};
+    float ssim{};
+    float colour_difference{};
+};
+
+// frame time and error of a setting averaged over the views, with its place on the pareto front
+// of frame time against each metric
+struct sweep_result_t {
+    sweep_setting_t setting{};
+    float           frame_time{};
+    image_quality_t quality{};
+    bool            pareto_psnr{};
+    bool            pareto_ssim{};
+    bool            pareto_colour_difference{};
+};
+
+// every combination of the swept step counts, blur and blue noise jitter
+[[nodiscard]] auto sweep_settings() -> std::vector<sweep_setting_t>;
+
+// psnr, ssim and colour difference of two RGBA images of the same size, see image_metrics.hpp
+[[nodiscard]] auto measure_image_quality(const std::vector<float> &image,
+                                         const std::vector<float> &reference,
+                                         std::uint32_t             width,
+                                         std::uint32_t             height,
+                                         float                     exposure_factor) -> image_quality_t;
+
+// flags the settings no other setting beats in frame time and the metric at once
+auto mark_pareto_fronts(std::vector<sweep_result_t> &results) -> void;
+
+// one row per setting with its frame time, metrics and pareto flags
+auto write_sweep_csv(const std::string &path, const std::vector<sweep_result_t> &results) -> bool;
+// the settings on each pareto front ordered by frame time, as aligned text
+auto write_pareto_table(std::ostream &stream, const std::vector<sweep_result_t> &results) -> void;
+
+// renders a reference of every benchmark view with high step counts averaged over jittered frames, then every
+// quality setting, the metrics against the reference run on worker threads while the gpu renders, writes the
+// csv and the pareto table to the sweep directory
+auto run_quality_sweep(const offline_renderer_t &renderer, const command_line_t &command_line) -> void;
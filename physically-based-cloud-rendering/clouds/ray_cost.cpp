@@ -0,0 +1,87 @@
+#include "ray_cost.hpp"
+
+#include <glbinding/gl/functions.h>
+
+namespace {
+// costed pixels, the totals as low and high words and the histograms of every counter, see ray_cost in ray_march.glsl
+constexpr auto buffer_size = (1U + 2U * ray_cost_t::counters + ray_cost_t::counters * ray_cost_t::histogram_bins) * sizeof(std::uint32_t);
+} // namespace
+
+ray_cost_t::ray_cost_t(std::uint32_t width, std::uint32_t height) noexcept
+    : image_{width, height, 0, nullptr, gl::GLenum::GL_RGBA32F, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, gl::GLenum::GL_NEAREST, gl::GLenum::GL_NEAREST}
+{
+    gl::glGenBuffers(static_cast<gl::GLsizei>(buffers_.size()), buffers_.data());
+    for (const auto buffer: buffers_) {
+        gl::glBindBuffer(gl::GLenum::GL_SHADER_STORAGE_BUFFER, buffer);
+        gl::glBufferData(gl::GLenum::GL_SHADER_STORAGE_BUFFER, buffer_size, nullptr, gl::GLenum::GL_DYNAMIC_READ);
+    }
+}
+
+ray_cost_t::~ray_cost_t() noexcept
+{
+    for (const auto fence: fences_) {
+        if (fence != nullptr) {
+            gl::glDeleteSync(fence);
+        }
+    }
+    gl::glDeleteBuffers(static_cast<gl::GLsizei>(buffers_.size()), buffers_.data());
+}
+
+auto ray_cost_t::begin_frame() noexcept -> void
+{
+    // a gpu more than frames_in_flight behind never gets this frame read back
+    if (fences_[current_] != nullptr) {
+        gl::glDeleteSync(fences_[current_]);
+        fences_[current_] = nullptr;
+    }
+
+    gl::glClearTexImage(image_.id(), 0, gl::GLenum::GL_RGBA, gl::GLenum::GL_FLOAT, nullptr);
+    gl::glClearNamedBufferData(buffers_[current_], gl::GLenum::GL_R32UI, gl::GLenum::GL_RED_INTEGER, gl::GLenum::GL_UNSIGNED_INT, nullptr);
+
+    gl::glBindImageTexture(2, image_.id(), 0, false, 0, gl::GLenum::GL_WRITE_ONLY, gl::GLenum::GL_RGBA32F);
+    gl::glBindBufferBase(gl::GLenum::GL_SHADER_STORAGE_BUFFER, 2, buffers_[current_]);
+}
+
+auto ray_cost_t::end_frame() noexcept -> void
+{
+    gl::glMemoryBarrier(gl::MemoryBarrierMask::GL_TEXTURE_FETCH_BARRIER_BIT | gl::MemoryBarrierMask::GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    fences_[current_] = gl::glFenceSync(gl::GLenum::GL_SYNC_GPU_COMMANDS_COMPLETE, gl::UnusedMask::GL_UNUSED_BIT);
+    current_          = (current_ + 1) % buffers_.size();
+
+    // from the oldest frame in flight to this one, the first unfinished frame stops the read back
+    for (auto i{std::size_t{}}; i < buffers_.size(); i++) {
+        const auto frame = (current_ + i) % buffers_.size();
+        if (fences_[frame] == nullptr) {
+            continue;
+        }
+
+        const auto status = gl::glClientWaitSync(fences_[frame], gl::SyncObjectMask::GL_SYNC_FLUSH_COMMANDS_BIT, 0U);
+        if (status == gl::GLenum::GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        gl::glDeleteSync(fences_[frame]);
+        fences_[frame] = nullptr;
+
+        auto values{std::array<std::uint32_t, buffer_size / sizeof(std::uint32_t)>{}};
+        gl::glGetNamedBufferSubData(buffers_[frame], 0, buffer_size, values.data());
+
+        statistics_.pixels = values[0];
+        for (auto counter{0U}; counter < counters; counter++) {
+            statistics_.totals[counter] = static_cast<std::uint64_t>(values[2 + 2 * counter]) << 32U | values[1 + 2 * counter];
+            for (auto bin{0U}; bin < histogram_bins; bin++) {
+                statistics_.histograms[counter][bin] = static_cast<float>(values[1 + 2 * counters + counter * histogram_bins + bin]);
+            }
+        }
+    }
+}
+
+auto ray_cost_t::bind(std::int32_t unit) const noexcept -> void
+{
+    image_.bind(unit);
+}
+
+auto ray_cost_t::statistics() const noexcept -> const statistics_t &
+{
+    return statistics_;
+}
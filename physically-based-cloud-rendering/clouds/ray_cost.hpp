@@ -0,0 +1,47 @@
+#pragma once
+
+#include "texture.hpp"
+
+#include <array>
+#include <cstdint>
+
+// per pixel cost of the ray marcher, primary steps, secondary density samples and erosion fetches,
+// written to an image for the heatmap and summed into totals and log2 histograms per frame, the buffers
+// of the frames in flight are read back once their fences show the gpu finished them, so the statistics
+// trail the frame by the depth of the driver queue without waiting for it
+class ray_cost_t {
+public:
+    static constexpr auto counters       = 3U;
+    static constexpr auto histogram_bins = 32U;
+
+    struct statistics_t {
+        std::uint32_t                                           pixels{};
+        std::array<std::uint64_t, counters>                     totals{};
+        // bin 0 holds pixels without any cost, bin n pixels with a cost in [2^(n-1), 2^n)
+        std::array<std::array<float, histogram_bins>, counters> histograms{};
+    };
+
+    ray_cost_t(std::uint32_t width, std::uint32_t height) noexcept;
+    ray_cost_t(const ray_cost_t &) = delete;
+    ray_cost_t(ray_cost_t &&)      = delete; // YAGNI
+    auto operator=(const ray_cost_t &) = delete;
+    auto operator=(ray_cost_t &&) = delete; // YAGNI
+    ~ray_cost_t() noexcept;
+
+    // clears and binds the image and the buffer of this frame for the ray marcher
+    auto begin_frame() noexcept -> void;
+    // fences this frame and reads back the statistics of the newest finished one
+    auto end_frame() noexcept -> void;
+    auto bind(std::int32_t unit = -1) const noexcept -> void;
+
+    [[nodiscard]] auto statistics() const noexcept -> const statistics_t &;
+
+private:
+    static constexpr auto frames_in_flight = 3U;
+
+    texture_t<2U>                               image_{};
+    std::array<std::uint32_t, frames_in_flight> buffers_{};
+    std::array<gl::GLsync, frames_in_flight>    fences_{};
+    std::size_t                                 current_{};
+    statistics_t                                statistics_{};
+};
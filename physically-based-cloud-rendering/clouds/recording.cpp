@@ -0,0 +1,118 @@
+#include "recording.hpp"
+
+#include <iostream>
+
+namespace {
+// the version changes with the layout of parameter_snapshot_t, the size in the header catches
+// builds that forgot to bump it
+constexpr auto magic   = std::array{'c', 'l', 'o', 'u', 'd', 'r', 'e', 'c'};
+constexpr auto version = std::uint32_t{1};
+
+constexpr auto parameters_tag = 'p';
+constexpr auto frame_tag      = 'f';
+
+template <typename T>
+auto write(std::ofstream &file, const T &value) -> void
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+auto read(std::ifstream &file, T &value) -> bool
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+// indices into the arrays of the viewer and the values it divides by
+auto in_limits(const parameter_snapshot_t &parameters, const parameter_limits_t &limits) -> bool
+{
+    return parameters.screen_width > 0 && parameters.screen_height > 0 && parameters.configuration >= 0 &&
+           parameters.configuration < limits.configurations && parameters.density_volume_resolution >= 0 &&
+           parameters.density_volume_resolution < limits.density_volume_resolutions &&
+           (parameters.resolution_scale == 1 || parameters.resolution_scale == 2 || parameters.resolution_scale == 4);
+}
+} // namespace
+
+recorder_t::recorder_t(const std::string &path)
+    : file_{path, std::ios::binary}
+{
+    write(file_, magic);
+    write(file_, version);
+    write(file_, static_cast<std::uint32_t>(sizeof(parameter_snapshot_t)));
+}
+
+auto recorder_t::is_open() const noexcept -> bool
+{
+    return static_cast<bool>(file_);
+}
+
+auto recorder_t::record(float time, const glm::vec4 &position, const glm::vec3 &rotation, const parameter_snapshot_t &parameters) -> void
+{
+    if (parameters_ != parameters) {
+        write(file_, parameters_tag);
+        write(file_, parameters);
+        parameters_ = parameters;
+    }
+
+    write(file_, frame_tag);
+    write(file_, time);
+    write(file_, glm::vec3{position});
+    write(file_, rotation);
+}
+
+auto read_recording(const std::string &path, const parameter_limits_t &limits) -> std::optional<recording_t>
+{
+    auto file{std::ifstream{path, std::ios::binary}};
+    if (!file) {
+        std::cerr << "cannot open recording " << path << std::endl;
+        return std::nullopt;
+    }
+
+    auto file_magic{decltype(magic){}};
+    auto file_version{std::uint32_t{}};
+    auto parameters_size{std::uint32_t{}};
+    if (!read(file, file_magic) || file_magic != magic || !read(file, file_version) || !read(file, parameters_size)) {
+        std::cerr << path << " is not a recording" << std::endl;
+        return std::nullopt;
+    }
+    if (file_version != version || parameters_size != sizeof(parameter_snapshot_t)) {
+        std::cerr << path << " was recorded by an incompatible build" << std::endl;
+        return std::nullopt;
+    }
+
+    auto recording{recording_t{}};
+    auto tag{char{}};
+    while (read(file, tag)) {
+        if (tag == parameters_tag) {
+            auto parameters{parameter_snapshot_t{}};
+            if (!read(file, parameters)) {
+                break;
+            }
+            if (!in_limits(parameters, limits)) {
+                std::cerr << path << " has parameters out of range after " << recording.frames.size() << " frames" << std::endl;
+                return std::nullopt;
+            }
+            recording.parameters.push_back(parameters);
+        } else if (tag == frame_tag && !recording.parameters.empty()) {
+            auto frame{recorded_frame_t{}};
+            auto position{glm::vec3{}};
+            if (!read(file, frame.time) || !read(file, position) || !read(file, frame.rotation)) {
+                break;
+            }
+            frame.position   = glm::vec4{position, 1.0F};
+            frame.parameters = recording.parameters.size() - 1;
+            recording.frames.push_back(frame);
+        } else {
+            std::cerr << path << " is corrupt after " << recording.frames.size() << " frames" << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    // a run that was killed leaves a partial record at the end, the frames before it are kept
+    if (recording.frames.empty()) {
+        std::cerr << path << " has no frames" << std::endl;
+        return std::nullopt;
+    }
+
+    return recording;
+}
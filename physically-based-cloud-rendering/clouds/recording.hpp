@@ -0,0 +1,129 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// every field of the active configuration and every option of the viewer, written to the log as is,
+// 4 byte fields come first and the flags last so the struct has no padding
+struct parameter_snapshot_t {
+    std::int32_t screen_width{};
+    std::int32_t screen_height{};
+
+    // configuration_t, the weather map follows from the index
+    std::int32_t configuration{};
+    float        base_scale{};
+    float        detail_scale{};
+    float        weather_scale{};
+    float        detail_factor{};
+    glm::vec3    min{};
+    glm::vec3    max{};
+    float        a{};
+    float        b{};
+    float        c{};
+    float        extinction{};
+    float        scattering{};
+    float        global_coverage{};
+
+    std::int32_t visualization{};
+    std::int32_t heatmap_counter{};
+    float        heatmap_max_cost{};
+    float        sun_intensity{};
+    float        anvil_bias{};
+    float        coverage_multiplier{};
+    float        exposure_factor{};
+    float        turbidity{};
+    std::int32_t blur_radius{};
+    std::int32_t blur_downsample_levels{};
+    std::int32_t denoise_iterations{};
+    float        denoise_depth_sigma{};
+    float        denoise_transmittance_sigma{};
+    float        denoise_luminance_sigma{};
+    std::int32_t octaves{};
+    std::int32_t primary_ray_steps{};
+    std::int32_t secondary_ray_steps{};
+    float        cloud_speed{};
+    float        density_multiplier{};
+    glm::vec3    wind_direction{};
+    glm::vec3    sun_direction{};
+    std::int32_t resolution_scale{};
+    float        render_scale{};
+    float        ray_march_budget{};
+    float        frame_time_target{};
+    std::int32_t progressive_max_frames{};
+    std::int32_t volume_slices_per_frame{};
+    std::int32_t density_volume_resolution{};
+    std::int32_t compute_segment_steps{};
+    float        erosion_fade_start{};
+    float        erosion_fade_end{};
+    std::int32_t cone_light_steps{};
+    float        cone_spread{};
+
+    bool                multiple_scattering_approximation{};
+    bool                blue_noise{};
+    bool                blur{};
+    bool                denoise{};
+    bool                ambient{};
+    bool                dynamic_resolution{};
+    bool                govern_quality{};
+    bool                progressive{};
+    bool                progressive_raise_steps{};
+    bool                adaptive_step_size{};
+    bool                empty_space_skipping{};
+    bool                temporal_reprojection{};
+    bool                use_light_volume{};
+    bool                use_density_volume{};
+    bool                use_brick_pool{};
+    bool                density_bounds_skipping{};
+    bool                use_height_profile{};
+    bool                compute_ray_marching{};
+    bool                detail_lod{};
+    bool                use_multiple_scattering_lut{};
+    bool                cone_light_march{};
+    std::array<bool, 3> padding{};
+
+    auto operator==(const parameter_snapshot_t &) const -> bool = default;
+};
+
+struct recorded_frame_t {
+    // animation time of the frame in milliseconds
+    float     time{};
+    glm::vec4 position{};
+    glm::vec3 rotation{};
+    // index of the parameters of the frame in recording_t::parameters
+    std::size_t parameters{};
+};
+
+struct recording_t {
+    std::vector<parameter_snapshot_t> parameters{};
+    std::vector<recorded_frame_t>     frames{};
+};
+
+// writes the camera of every frame and the parameters whenever they change, a frame costs 29 bytes
+class recorder_t {
+public:
+    explicit recorder_t(const std::string &path);
+
+    [[nodiscard]] auto is_open() const noexcept -> bool;
+    auto record(float time, const glm::vec4 &position, const glm::vec3 &rotation, const parameter_snapshot_t &parameters) -> void;
+
+private:
+    std::ofstream                       file_{};
+    std::optional<parameter_snapshot_t> parameters_{};
+};
+
+// number of entries of the arrays the indices of a snapshot select from
+struct parameter_limits_t {
+    std::int32_t configurations{};
+    std::int32_t density_volume_resolutions{};
+};
+
+// prints what is wrong with the file and returns nothing when it cannot be read or holds parameters
+// outside the limits
+[[nodiscard]] auto read_recording(const std::string &path, const parameter_limits_t &limits) -> std::optional<recording_t>;
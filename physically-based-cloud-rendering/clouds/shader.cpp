@@ -1,40 +1,58 @@
 #include "shader.hpp"
 
+#include "profiler.hpp"
+
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 
-shader_t::~shader_t() noexcept { gl::glDeleteProgram(id_); }
-
-shader_t::shader_t(const char *vertex_path, const char *fragment_path) noexcept
+namespace {
+// reads a shader source and splices in the files named by #include "file" lines,
+// paths are relative to the including file
+auto load_source(const std::filesystem::path &path) -> std::string
 {
-    auto vertex_code   = std::string{};
-    auto fragment_code = std::string{};
-
-    auto vertex_file{std::ifstream{vertex_path}};
-    auto fragment_file{std::ifstream{fragment_path}};
+    constexpr auto directive = std::string_view{"#include \""};
+
+    auto file{std::ifstream{path}};
+    auto stream{std::stringstream{}};
+    auto line{std::string{}};
+
+    while (std::getline(file, line)) {
+        if (line.starts_with(directive)) {
+            const auto end = line.find('"', directive.size());
+            stream << load_source(path.parent_path() / line.substr(directive.size(), end - directive.size()));
+        } else {
+            stream << line << '\n';
+        }
+    }
+
+    return stream.str();
+}
 
-    auto vertex_stream{std::stringstream{}};
-    auto fragment_stream{std::stringstream{}};
+auto compile(gl::GLenum type, const char *path) -> std::uint32_t
+{
+    const auto code   = load_source(path);
+    auto       p_data = code.data();
 
-    vertex_stream << vertex_file.rdbuf();
-    fragment_stream << fragment_file.rdbuf();
+    auto shader = glCreateShader(type);
+    assert(shader);
+    gl::glShaderSource(shader, 1, &p_data, nullptr);
+    gl::glCompileShader(shader);
 
-    vertex_code   = vertex_stream.str();
-    fragment_code = fragment_stream.str();
+    return shader;
+}
+} // namespace
 
-    auto p_vertex_data   = vertex_code.data();
-    auto p_fragment_data = fragment_code.data();
+shader_t::~shader_t() noexcept { gl::glDeleteProgram(id_); }
 
-    auto vertex = glCreateShader(gl::GLenum::GL_VERTEX_SHADER);
-    assert(vertex);
-    gl::glShaderSource(vertex, 1, &p_vertex_data, nullptr);
-    gl::glCompileShader(vertex);
+shader_t::shader_t(const char *vertex_path, const char *fragment_path) noexcept
+{
+    const auto zone = profile_zone_t{"compile shader", fragment_path};
 
-    auto fragment = glCreateShader(gl::GLenum::GL_FRAGMENT_SHADER);
-    assert(fragment);
-    gl::glShaderSource(fragment, 1, &p_fragment_data, nullptr);
-    gl::glCompileShader(fragment);
+    auto vertex   = compile(gl::GLenum::GL_VERTEX_SHADER, vertex_path);
+    auto fragment = compile(gl::GLenum::GL_FRAGMENT_SHADER, fragment_path);
 
     auto program = gl::glCreateProgram();
     assert(program);
@@ -48,6 +66,22 @@ shader_t::shader_t(const char *vertex_path, const char *fragment_path) noexcept
     id_ = program;
 }
 
+shader_t::shader_t(const char *compute_path) noexcept
+{
+    const auto zone = profile_zone_t{"compile shader", compute_path};
+
+    auto compute = compile(gl::GLenum::GL_COMPUTE_SHADER, compute_path);
+
+    auto program = gl::glCreateProgram();
+    assert(program);
+    gl::glAttachShader(program, compute);
+    gl::glLinkProgram(program);
+
+    gl::glDeleteShader(compute);
+
+    id_ = program;
+}
+
 auto shader_t::use() const noexcept -> void
 {
     assert(id_);
@@ -7,6 +7,7 @@ class shader_t {
 public:
     shader_t() = default;
     shader_t(const char *vertex_path, const char *fragment_path) noexcept;
+    explicit shader_t(const char *compute_path) noexcept;
     shader_t(const shader_t &) = delete;
     shader_t(shader_t &&)      = delete; // YAGNI
     auto operator=(const shader_t &) = delete;
@@ -36,6 +37,14 @@ public:
             gl::glUniform4fv(gl::glGetUniformLocation(id_, name),
                              1,
                              reinterpret_cast<const float *>(&value));
+        } else if constexpr (std::is_same_v<type, glm::ivec2>) {
+            gl::glUniform2iv(gl::glGetUniformLocation(id_, name),
+                             1,
+                             reinterpret_cast<const std::int32_t *>(&value));
+        } else if constexpr (std::is_same_v<type, glm::ivec3>) {
+            gl::glUniform3iv(gl::glGetUniformLocation(id_, name),
+                             1,
+                             reinterpret_cast<const std::int32_t *>(&value));
         } else if constexpr (std::is_same_v<type, bool>) {
             gl::glUniform1i(gl::glGetUniformLocation(id_, name), static_cast<std::int32_t>(value));
         } else if constexpr (std::is_same_v<type, std::int32_t>) {
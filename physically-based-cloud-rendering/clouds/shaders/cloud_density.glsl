@@ -0,0 +1,372 @@
+// cloud density model shared by every pass that samples the clouds
+
+uniform sampler2D weather_map;
+uniform sampler3D cloud_base;
+uniform sampler3D cloud_erosion;
+
+uniform int low_frequency_noise_visualization;
+uniform float weather_map_scale;
+uniform float low_freq_noise_scale;
+uniform float high_freq_noise_scale;
+uniform float high_freq_noise_factor;
+uniform float time;
+uniform float cloud_speed;
+uniform vec3 wind_direction;
+uniform float global_cloud_coverage;
+uniform float anvil_bias;
+uniform float coverage_mult;
+uniform float density_mult;
+
+uniform vec3 aabb_min = vec3(-30000, 1000, -30000);
+uniform vec3 aabb_max = vec3(30000, 4000, 30000);
+const vec2 weather_map_min = vec2(-30000, -30000);
+const vec2 weather_map_max = vec2(30000, 30000);
+
+// sample_cloud_density baked over the aabb, see density_volume.comp
+uniform bool use_density_volume = false;
+uniform sampler3D density_volume;
+// time of the clouds in the density volume, they have moved with the wind since
+uniform float density_volume_time = 0.0;
+
+// sparse bake, a page table entry is either a constant density or the index of a brick in the atlas,
+// see brick_classify.comp
+uniform bool use_brick_pool = false;
+uniform usampler3D brick_pages;
+uniform sampler3D brick_atlas;
+// time of the clouds in the brick pool, they have moved with the wind since
+uniform float brick_pool_time = 0.0;
+
+const int brick_size = 8;
+const int brick_apron = 1;
+const int stored_brick_size = brick_size + 2*brick_apron;
+const uint constant_brick = 0x80000000u;
+const uint empty_brick = constant_brick;
+
+// height profiles of the cloud types tabulated on the CPU, see height_profile.cpp
+uniform bool use_height_profile = false;
+uniform sampler2D height_profile_lut;
+
+// distances in metres over which primary samples blend the erosion out, see sample_cloud_density_footprint
+uniform float erosion_fade_start = 15000.0;
+uniform float erosion_fade_end = 30000.0;
+
+const float eps = 0.1;
+
+// erosion noise fetches of the invocation, reported by the ray cost instrumentation
+int erosion_fetches = 0;
+
+// erosion noise averaged over more than 4x4x4 texels barely changes the density
+const float max_erosion_lod = 2.0;
+
+float remap(float original_value , float original_min , float original_max , float new_min , float new_max) 
+{
+    return new_min + (((original_value - original_min) / (original_max - original_min)) * (new_max - new_min));
+}
+
+float get_height_relative_to_cloud_type(float relative_height, float cloud_type)
+{
+    float stratocumulus = 0.6; 
+    float cumulus_and_stratus = 0.0;
+
+    if (abs(cloud_type - 1.0) < eps || abs(cloud_type) < eps)
+    {
+        return relative_height - cumulus_and_stratus;
+    }
+
+    return relative_height - stratocumulus;
+}
+
+float get_distance_to_top_relative_to_cloud_type(float relative_height, float cloud_type)
+{
+    float stratus = 0.3;
+    float cumulus_and_stratocumulus = 1.0;
+
+    if (abs(cloud_type - 1.0) < eps)
+    {
+        return cumulus_and_stratocumulus - relative_height;
+    }
+
+    if (abs(cloud_type) < eps)
+    {
+        return stratus - relative_height;
+    }
+
+    return cumulus_and_stratocumulus - relative_height;
+}
+
+float get_height_coverage(float relative_height, float cloud_type)
+{
+    float cumulus_and_stratus = 0.0;
+    float stratocumulus = 0.6; 
+    float stratus = 0.0; 
+
+    if (abs(cloud_type - 1.0) < eps || abs(cloud_type) < eps)
+    {
+       // return 1;
+        return clamp(remap(relative_height - cumulus_and_stratus, 0, 0.25, 1.25, 1), 1.0,1.25);
+    }
+
+    float test = relative_height - stratocumulus;
+    if (test < 0) return 0;
+    return clamp(remap(relative_height - stratocumulus, 0.6, 0.65, 1.25, 1), 1.0,1.25);
+}
+
+float get_height_gradient(float relative_height, float cloud_type)
+{
+    if (abs(cloud_type - 1.0) < eps)
+    {
+        return clamp(remap(relative_height, 0.0, 0.15, 0.0, 1.0),0, 1) * clamp(remap(relative_height, 0.6, 1.0, 1.0, 0.0), 0, 1);
+    }
+    else if (abs(cloud_type) < eps)
+    {
+        return clamp(remap(relative_height, 0.0, 0.05, 0.0, 1.0), 0, 1) * clamp(remap(relative_height, 0.2, 0.3, 1.0, 0.0), 0, 1); 
+    }
+    else 
+    {
+        return clamp(remap(relative_height, 0.6, 0.65, 0.0, 1.0), 0, 1) * clamp(remap(relative_height,  0.9, 1.0, 1.0, 0.0), 0, 1); 
+    }
+}
+
+// height gradient, coverage scale, cloud base and cloud top of a cloud type at a relative height,
+// the table interpolates between cloud types where the functions above switch at eps
+vec4 get_height_profile(float relative_height, float cloud_type)
+{
+    if (use_height_profile)
+    {
+        // the end texels hold relative heights 0 and 1, outside of them the profiles are constant
+        vec2 size = vec2(textureSize(height_profile_lut, 0));
+        vec2 coords = clamp(vec2(relative_height, cloud_type), 0.0, 1.0);
+        return texture(height_profile_lut, (coords*(size - 1.0) + 0.5)/size);
+    }
+
+    return vec4(get_height_gradient(relative_height, cloud_type),
+                get_height_coverage(relative_height, cloud_type),
+                relative_height - get_height_relative_to_cloud_type(relative_height, cloud_type),
+                relative_height + get_distance_to_top_relative_to_cloud_type(relative_height, cloud_type));
+}
+
+float get_coverage(vec3 weather_data, vec4 height_profile)
+{
+    float cloud_coverage_x = weather_data.x;
+    float cloud_coverage_y = weather_data.y;
+
+    float cloud_coverage = mix(cloud_coverage_x, cloud_coverage_y, global_cloud_coverage);
+    float retval = cloud_coverage*height_profile.y;
+
+    return retval;
+}
+
+
+// base cloud shape from the low frequency noise, weather map and height profiles
+float shape_low_frequency_density(vec4 low_frequency_noises, vec3 weather_data, float relative_height, vec4 height_profile)
+{
+    float low_freq_FBM = low_frequency_noises.y * 0.625 + 
+                         low_frequency_noises.z * 0.250 +
+                         low_frequency_noises.w * 0.125;
+
+    //float base_cloud = clamp(remap(low_frequency_noises.x, -(1-low_freq_FBM), 1.0, 0.0, 1.0), 0, 1);
+    float base_cloud = clamp(remap(low_freq_FBM, low_frequency_noises.x, 1.0, 0.0, 1.0), 0, 1);
+    base_cloud *= height_profile.x;
+
+    float coverage = get_coverage(weather_data, height_profile) *coverage_mult;
+    float anvil_factor = clamp(remap(relative_height, 0.6, 1.0, 1.0, mix(1.0, 0.1, anvil_bias)), 0.1, 1.0);
+    coverage = pow(coverage, anvil_factor);
+
+    float base_cloud_with_coverage = clamp(remap(base_cloud,  1 - coverage, 1, 0, 1), 0 , 1);
+    base_cloud_with_coverage *=  coverage;
+
+    return base_cloud_with_coverage;
+}
+
+// full detail samples read the base level of the mipmapped noises, implicit derivatives are undefined
+// inside the ray march loops
+float sample_low_frequency_density(vec3 samplepoint, vec3 weather_data, float relative_height, vec4 height_profile)
+{
+    return shape_low_frequency_density(textureLod(cloud_base, samplepoint/low_freq_noise_scale, 0.0), weather_data, relative_height, height_profile);
+}
+
+// erodes the edges of the base cloud shape with the high frequency noise
+float shape_eroded_density(float base_cloud, vec4 high_frequency_noises, vec3 weather_data, float relative_height, vec4 height_profile)
+{
+    // todo: curl noise?
+    float high_freq_FBM =     (high_frequency_noises.x * 0.625)
+                            + (high_frequency_noises.y * 0.250)
+                            + (high_frequency_noises.z * 0.125);
+
+    float high_freq_noise_modifier = mix(high_freq_FBM,  1 - high_freq_FBM, clamp((relative_height - height_profile.z)* 10.0, 0.0, 1.0));
+    return clamp(remap(base_cloud, high_freq_noise_modifier * high_freq_noise_factor, 1.0, 0.0, 1.0), 0.0, 1.0); 
+}
+
+float erode_cloud_density(float base_cloud, vec3 samplepoint, vec3 weather_data, float relative_height, vec4 height_profile)
+{
+    erosion_fetches++;
+    return shape_eroded_density(base_cloud, textureLod(cloud_erosion, samplepoint/high_freq_noise_scale, 0.0), weather_data, relative_height, height_profile);
+}
+
+// the sample_cloud_density functions take points already moved with the wind, the noise moves together with
+// the weather map so the clouds baked at an earlier time are the current ones shifted by the wind since then
+float sample_cloud_density(vec3 samplepoint, vec3 weather_data, float relative_height)
+{
+    vec4 height_profile = get_height_profile(relative_height, weather_data.z);
+
+    float final_cloud = sample_low_frequency_density(samplepoint, weather_data, relative_height, height_profile);
+    if (low_frequency_noise_visualization == 1.0)
+    {
+        return final_cloud * density_mult;
+    }
+
+    if(final_cloud > 0.0)
+    {
+        final_cloud = erode_cloud_density(final_cloud, samplepoint, weather_data, relative_height, height_profile);
+    }
+
+    return final_cloud * density_mult;
+}
+
+// cheap test used by the adaptive marcher to find cloud, low frequency noise only
+float sample_cloud_density_coarse(vec3 samplepoint, vec3 weather_data, float relative_height)
+{
+    vec4 height_profile = get_height_profile(relative_height, weather_data.z);
+
+    return sample_low_frequency_density(samplepoint, weather_data, relative_height, height_profile) * density_mult;
+}
+
+// density for samples with a wide footprint, lod is the mip level of the base noise,
+// the erosion noise is skipped once its features are much smaller than the footprint
+float sample_cloud_density_lod(vec3 samplepoint, vec3 weather_data, float relative_height, float lod)
+{
+    vec4 low_frequency_noises = textureLod(cloud_base, samplepoint/low_freq_noise_scale, lod);
+    vec4 height_profile = get_height_profile(relative_height, weather_data.z);
+
+    float final_cloud = shape_low_frequency_density(low_frequency_noises, weather_data, relative_height, height_profile);
+    if (low_frequency_noise_visualization == 1.0)
+    {
+        return final_cloud * density_mult;
+    }
+
+    // the erosion texture repeats over a shorter distance, so its level is higher for the same footprint
+    float texels_per_base_texel = (low_freq_noise_scale/textureSize(cloud_base, 0).x)/(high_freq_noise_scale/textureSize(cloud_erosion, 0).x);
+    float erosion_lod = lod + log2(max(texels_per_base_texel, 1e-6));
+
+    if(final_cloud > 0.0 && erosion_lod < max_erosion_lod)
+    {
+        erosion_fetches++;
+        vec4 high_frequency_noises = textureLod(cloud_erosion, samplepoint/high_freq_noise_scale, max(erosion_lod, 0.0));
+        final_cloud = shape_eroded_density(final_cloud, high_frequency_noises, weather_data, relative_height, height_profile);
+    }
+
+    return final_cloud * density_mult;
+}
+
+// density for primary ray samples, the noise mips follow the footprint of the pixel cone and
+// the erosion fades out between erosion_fade_start and erosion_fade_end, so far samples skip its fetch
+float sample_cloud_density_footprint(vec3 samplepoint, vec3 weather_data, float relative_height, float footprint, float view_distance)
+{
+    float lod = max(log2(footprint/(low_freq_noise_scale/textureSize(cloud_base, 0).x)), 0.0);
+    vec4 low_frequency_noises = textureLod(cloud_base, samplepoint/low_freq_noise_scale, lod);
+    vec4 height_profile = get_height_profile(relative_height, weather_data.z);
+
+    float final_cloud = shape_low_frequency_density(low_frequency_noises, weather_data, relative_height, height_profile);
+    if (low_frequency_noise_visualization == 1.0)
+    {
+        return final_cloud * density_mult;
+    }
+
+    float erosion_weight = 1.0 - smoothstep(erosion_fade_start, erosion_fade_end, view_distance);
+    if(final_cloud > 0.0 && erosion_weight > 0.0)
+    {
+        float erosion_lod = max(log2(footprint/(high_freq_noise_scale/textureSize(cloud_erosion, 0).x)), 0.0);
+        erosion_fetches++;
+        vec4 high_frequency_noises = textureLod(cloud_erosion, samplepoint/high_freq_noise_scale, erosion_lod);
+        float eroded_cloud = shape_eroded_density(final_cloud, high_frequency_noises, weather_data, relative_height, height_profile);
+        final_cloud = mix(final_cloud, eroded_cloud, erosion_weight);
+    }
+
+    return final_cloud * density_mult;
+}
+
+// full density at a point in world space, the way the fine steps of the ray marcher sample it
+float sample_cloud_density_at(vec3 point)
+{
+    float relative_height = (point.y - aabb_min.y)/(aabb_max.y - aabb_min.y);
+    vec3 sampling_location = point + (wind_direction)*time*cloud_speed;
+    vec4 weather_data = texture(weather_map, (sampling_location.xz + weather_map_min.xy)/(weather_map_scale));
+    return sample_cloud_density(sampling_location, weather_data.xyz, relative_height);
+}
+
+// centre of a voxel of the brick pool's virtual volume in world space
+vec3 get_brick_voxel_centre(ivec3 voxel, ivec3 pages)
+{
+    return aabb_min + (vec3(voxel) + 0.5)/vec3(pages*brick_size)*(aabb_max - aabb_min);
+}
+
+// baked density at a point in world space, replaces the weather map and noise fetches
+float sample_density_volume(vec3 point)
+{
+    // keep the lookup off the border texels, the volume does not wrap
+    vec3 half_texel = 0.5/vec3(textureSize(density_volume, 0));
+    vec3 baked_point = point + wind_direction*(time - density_volume_time)*cloud_speed;
+    vec3 uvw = clamp((baked_point - aabb_min)/(aabb_max - aabb_min), half_texel, 1.0 - half_texel);
+    return texture(density_volume, uvw).r;
+}
+
+// no intersection means vec.x > vec.y (really tNear > tFar)
+vec2 intersect_aabb(vec3 ray_origin, vec3 ray_dir, vec3 box_min, vec3 box_max)
+{
+    vec3 tMin = (box_min - ray_origin) / ray_dir;
+    vec3 tMax = (box_max - ray_origin) / ray_dir;
+    vec3 t1 = min(tMin, tMax);
+    vec3 t2 = max(tMin, tMax);
+    float tNear = max(max(t1.x, t1.y), t1.z);
+    float tFar = min(min(t2.x, t2.y), t2.z);
+    return vec2(tNear, tFar);
+}
+
+float sample_brick_pool(vec3 point)
+{
+    point += wind_direction*(time - brick_pool_time)*cloud_speed;
+    ivec3 pages = textureSize(brick_pages, 0);
+    vec3 voxel = clamp((point - aabb_min)/(aabb_max - aabb_min), 0.0, 1.0)*vec3(pages*brick_size);
+    ivec3 page = min(ivec3(voxel)/brick_size, pages - 1);
+
+    uint entry = texelFetch(brick_pages, page, 0).r;
+    if ((entry & constant_brick) != 0u)
+    {
+        return unpackHalf2x16(entry).x;
+    }
+
+    // the apron holds the neighbouring voxels, filtering reaches into it up to the brick border
+    // and so never reads another brick
+    ivec3 atlas_size = textureSize(brick_atlas, 0);
+    ivec3 atlas_bricks = atlas_size/stored_brick_size;
+    ivec3 slot = ivec3(entry % atlas_bricks.x, (entry/atlas_bricks.x) % atlas_bricks.y, entry/(atlas_bricks.x*atlas_bricks.y));
+    vec3 local = clamp(voxel - vec3(page*brick_size), 0.0, float(brick_size));
+    vec3 atlas_coords = vec3(slot*stored_brick_size + brick_apron) + local;
+    return texture(brick_atlas, atlas_coords/vec3(atlas_size)).r;
+}
+
+// distance along the ray to the exit of the brick around the point when it is empty, zero otherwise
+float get_empty_brick_distance(vec3 point, vec3 dir)
+{
+    point += wind_direction*(time - brick_pool_time)*cloud_speed;
+    ivec3 pages = textureSize(brick_pages, 0);
+    vec3 page_extent = (aabb_max - aabb_min)/vec3(pages);
+    ivec3 page = ivec3(floor((point - aabb_min)/page_extent));
+    if (any(lessThan(page, ivec3(0))) || any(greaterThanEqual(page, pages)) || texelFetch(brick_pages, page, 0).r != empty_brick)
+    {
+        return 0.0;
+    }
+
+    vec3 brick_min = aabb_min + vec3(page)*page_extent;
+    return max(intersect_aabb(point, dir, brick_min, brick_min + page_extent).y, 0.0);
+}
+
+bool use_baked_density()
+{
+    return use_brick_pool || use_density_volume;
+}
+
+float sample_baked_density(vec3 point)
+{
+    return use_brick_pool ? sample_brick_pool(point) : sample_density_volume(point);
+}
@@ -0,0 +1,23 @@
+const float pi = 3.141592653589793238462643383279502884197169;
+const float one_over_pi = 1.0/pi;
+
+uniform sampler1D mie_texture;
+
+float hg(float costheta, float g) 
+{
+    return 0.25 * one_over_pi * (1 - pow(g, 2.0)) / pow((1 + pow(g, 2.0) - 2 * g * costheta), 1.5);
+}
+
+// phase function of the i-th scattering octave, c attenuates the eccentricity of later octaves
+vec3 phase_ms(float costheta, float c, int i)
+{
+    float theta = acos(costheta);
+    if (i == 0)
+    {
+        return texture(mie_texture, theta/pi).rgb;
+    }
+    else 
+    {
+        return vec3(0.8*hg(costheta, 0.9*pow(c, i/2.0)) +0.2*hg(costheta, -0.5*pow(c, i/2.0)));
+    }
+}
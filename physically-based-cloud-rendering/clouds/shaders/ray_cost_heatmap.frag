@@ -0,0 +1,23 @@
+#version 460 core
+out vec4 fragment_colour;
+
+in vec2 uvs;
+
+// one counter of the ray cost image on a log scale, see ray_cost.cpp
+uniform sampler2D ray_cost;
+uniform int counter = 0;
+uniform float max_cost = 256.0;
+
+vec3 heat(float t)
+{
+    return clamp(vec3(1.5 - abs(4.0*t - 3.0), 1.5 - abs(4.0*t - 2.0), 1.5 - abs(4.0*t - 1.0)), 0.0, 1.0);
+}
+
+void main()
+{
+    // the cost image has the internal render resolution, not the one of the window
+    float cost = texelFetch(ray_cost, ivec2(uvs*vec2(textureSize(ray_cost, 0))), 0)[counter];
+    float t = clamp(log2(1.0 + cost)/log2(1.0 + max_cost), 0.0, 1.0);
+
+    fragment_colour = vec4(heat(t), 1.0);
+}
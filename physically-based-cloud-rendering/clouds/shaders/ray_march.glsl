@@ -0,0 +1,804 @@
+// ray marcher shared by raymarch.frag and raymarch.comp, the including stage sets pixel_coords
+
+#include "cloud_density.glsl"
+#include "phase.glsl"
+
+
+// window coordinates of the pixel being marched
+vec2 pixel_coords = vec2(0.0);
+
+uniform sampler2D blue_noise;
+// shifts the blue noise every frame while frames are accumulated, in texels
+uniform vec2 blue_noise_offset = vec2(0.0);
+
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 camera_pos;
+
+uniform int high_frequency_noise_visualization;
+uniform float scattering_factor;
+uniform float extinction_factor;
+uniform float sun_intensity;
+uniform int multiple_scattering_approximation;
+uniform int N;
+uniform float a;
+uniform float b;
+uniform float c;
+uniform int primary_ray_steps;
+uniform int secondary_ray_steps;
+uniform vec3 sun_direction;
+uniform int use_blue_noise;
+uniform bool use_ambient;
+uniform vec3 ambient_luminance_up;
+uniform vec3 ambient_luminance_down;
+uniform float turbidity;
+
+// adaptive marching takes coarse steps through empty space and fine steps inside cloud, cloud thinner
+// than a coarse step can fall between two coarse samples and is skipped
+uniform bool adaptive_step_size = false;
+uniform int coarse_step_factor = 4;
+uniform int empty_steps_before_widening = 8;
+
+// max coverage pyramid of the weather map used to skip empty columns
+uniform sampler2D occupancy_map;
+uniform int occupancy_levels;
+uniform bool empty_space_skipping = false;
+
+// min/max density per cell of the cloud layer with coarser cells in higher levels, see density_bounds.comp
+uniform bool density_bounds_skipping = false;
+uniform sampler3D density_bounds;
+uniform int density_bounds_levels;
+// time of the clouds in the density bounds, they have moved with the wind since
+uniform float density_bounds_time = 0.0;
+
+// density samples taken by all fragments, only counted for the reports, the high word takes the
+// carries of the low one
+uniform bool count_samples = false;
+layout(std430, binding = 1) buffer sample_counter
+{
+    uint density_samples;
+    uint density_samples_high;
+};
+int samples_taken = 0;
+
+void count_density_samples()
+{
+    uint samples = uint(samples_taken);
+    if (atomicAdd(density_samples, samples) > 0xffffffffu - samples)
+    {
+        atomicAdd(density_samples_high, 1u);
+    }
+}
+
+// per pixel cost of the ray marcher, the counts of every pixel go to cost_image and the totals and
+// log2 histograms of the frame to the ray_cost buffer, see ray_cost.cpp
+uniform bool count_cost = false;
+layout(rgba32f, binding = 2) uniform writeonly image2D cost_image;
+layout(std430, binding = 2) buffer ray_cost
+{
+    uint costed_pixels;
+    // a low and a high word per counter, the totals of a frame can pass 2^32
+    uint cost_totals[3*2];
+    uint cost_histograms[3*32];
+};
+int primary_steps = 0;
+int secondary_samples = 0;
+// pixels along each axis a ray of a scaled down march stands in for, its cost is stored for all of them
+uniform int cost_footprint = 1;
+
+// primary steps, secondary density samples and erosion fetches taken by the invocation so far
+ivec3 get_cost_counters()
+{
+    return ivec3(primary_steps, secondary_samples, erosion_fetches);
+}
+
+void store_ray_cost(ivec2 pixel, ivec3 cost)
+{
+    ivec2 first_pixel = pixel - cost_footprint/2;
+    for (int y = 0; y < cost_footprint; y++)
+    {
+        for (int x = 0; x < cost_footprint; x++)
+        {
+            imageStore(cost_image, first_pixel + ivec2(x, y), vec4(cost, 0.0));
+        }
+    }
+    atomicAdd(costed_pixels, 1u);
+    for (int i = 0; i < 3; i++)
+    {
+        uint count = uint(cost[i]);
+        if (atomicAdd(cost_totals[2*i], count) > 0xffffffffu - count)
+        {
+            atomicAdd(cost_totals[2*i + 1], 1u);
+        }
+        atomicAdd(cost_histograms[32*i + min(findMSB(count) + 1, 31)], 1u);
+    }
+}
+
+// cached sun optical depth over the cloud layer, see light_volume.comp
+uniform bool use_light_volume = false;
+uniform sampler3D light_volume;
+// time of the clouds in the light volume, they have moved with the wind since
+uniform float light_volume_time = 0.0;
+
+// few exponentially growing light steps jittered inside a cone, see get_sun_transmittance_cone
+uniform bool cone_light_march = false;
+uniform int cone_light_steps = 6;
+uniform float cone_spread = 0.1;
+
+// distance and footprint based detail of the fine steps
+uniform bool detail_lod = false;
+// angle covered by one pixel of the marched image, footprints grow linearly with distance
+uniform float pixel_angle;
+
+// octave sum of the multiple scattering approximation, see multiple_scattering.comp
+uniform bool use_multiple_scattering_lut = false;
+uniform sampler2D multiple_scattering_lut;
+
+// temporal reprojection marches one pixel of every block_size x block_size block
+uniform int block_size = 1;
+uniform ivec2 pixel_offset = ivec2(0);
+uniform vec2 output_size;
+// when set only pixels flagged by the reprojection pass are marched
+uniform bool disoccluded_only = false;
+uniform sampler2D reprojection_mask;
+
+// cloud depth is stored in kilometres so it fits comfortably into a half float target
+const float cloud_depth_scale = 0.001;
+const float sky_depth = 100.0;
+
+//const vec3 sun_luminance = 683*vec3(69000, 64000, 59000);
+const vec3 sun_luminance_zenith = vec3(1.6e9);
+const vec3 sun_luminance_sunset = vec3(192.0/192, 106.0/192, 62.0/192)*vec3(1.2e9);
+vec3 sun_luminance = mix(sun_luminance_sunset, sun_luminance_zenith, dot(vec3(0, 1, 0),-sun_direction));
+
+const float sun_angular_diameter_cos = 0.999956676946448443553574619906976478926848692873900859324F;
+
+vec3 Yxy_to_XYZ( in vec3 Yxy )
+{
+	float Y = Yxy.r;
+	float x = Yxy.g;
+	float y = Yxy.b;
+
+	float X = x * ( Y / y );
+	float Z = ( 1.0 - x - y ) * ( Y / y );
+
+	return vec3(X,Y,Z);
+}
+
+vec3 XYZ_to_RGB( in vec3 XYZ )
+{
+	// CIE/E
+	mat3 M = mat3
+	(
+		 2.3706743, -0.9000405, -0.4706338,
+		-0.5138850,  1.4253036,  0.0885814,
+ 		 0.0052982, -0.0146949,  1.0093968
+	);
+
+	return XYZ * M;
+}
+
+float saturated_dot( in vec3 a, in vec3 b )
+{
+	return max( dot( a, b ), 0.0 );   
+}
+
+vec3 Yxy_to_RGB( in vec3 Yxy )
+{
+	vec3 XYZ = Yxy_to_XYZ( Yxy );
+	vec3 RGB = XYZ_to_RGB( XYZ );
+	return RGB;
+}
+
+void calculate_perez_distribution( in float t, out vec3 A, out vec3 B, out vec3 C, out vec3 D, out vec3 E )
+{
+	A = vec3(  0.1787 * t - 1.4630, -0.0193 * t - 0.2592, -0.0167 * t - 0.2608 );
+	B = vec3( -0.3554 * t + 0.4275, -0.0665 * t + 0.0008, -0.0950 * t + 0.0092 );
+	C = vec3( -0.0227 * t + 5.3251, -0.0004 * t + 0.2125, -0.0079 * t + 0.2102 );
+	D = vec3(  0.1206 * t - 2.5771, -0.0641 * t - 0.8989, -0.0441 * t - 1.6537 );
+	E = vec3( -0.0670 * t + 0.3703, -0.0033 * t + 0.0452, -0.0109 * t + 0.0529 );
+}
+
+vec3 calculate_zenith_luminance_Yxy( in float t, in float thetaS )
+{
+	float chi  	 	= ( 4.0 / 9.0 - t / 120.0 ) * ( pi - 2.0 * thetaS );
+	float Yz   	 	= ( 4.0453 * t - 4.9710 ) * tan( chi ) - 0.2155 * t + 2.4192;
+
+	float theta2 	= thetaS * thetaS;
+    float theta3 	= theta2 * thetaS;
+    float T 	 	= t;
+    float T2 	 	= t * t;
+
+	float xz =
+      ( 0.00165 * theta3 - 0.00375 * theta2 + 0.00209 * thetaS + 0.0)     * T2 +
+      (-0.02903 * theta3 + 0.06377 * theta2 - 0.03202 * thetaS + 0.00394) * T +
+      ( 0.11693 * theta3 - 0.21196 * theta2 + 0.06052 * thetaS + 0.25886);
+
+    float yz =
+      ( 0.00275 * theta3 - 0.00610 * theta2 + 0.00317 * thetaS + 0.0)     * T2 +
+      (-0.04214 * theta3 + 0.08970 * theta2 - 0.04153 * thetaS + 0.00516) * T +
+      ( 0.15346 * theta3 - 0.26756 * theta2 + 0.06670 * thetaS + 0.26688);
+
+	return vec3( Yz, xz, yz );
+}
+
+vec3 calculate_perez_luminance_Yxy( in float theta, in float gamma, in vec3 A, in vec3 B, in vec3 C, in vec3 D, in vec3 E )
+{
+	return ( 1.0 + A * exp( B / cos( theta ) ) ) * ( 1.0 + C * exp( D * gamma ) + E * cos( gamma ) * cos( gamma ) );
+}
+
+vec3 calculate_sky_luminance_RGB( in vec3 s, in vec3 e, in float t )
+{
+	vec3 A, B, C, D, E;
+	calculate_perez_distribution( t, A, B, C, D, E );
+
+	float thetaS = acos( saturated_dot( s, vec3(0,1,0) ) );
+	float thetaE = acos( saturated_dot( e, vec3(0,1,0) ) );
+	float gammaE = acos( saturated_dot( s, e )		   );
+
+	vec3 Yz = calculate_zenith_luminance_Yxy( t, thetaS );
+
+	vec3 fThetaGamma = calculate_perez_luminance_Yxy( thetaE, gammaE, A, B, C, D, E );
+	vec3 fZeroThetaS = calculate_perez_luminance_Yxy( 0.0,    thetaS, A, B, C, D, E );
+
+	vec3 Yp = Yz * ( fThetaGamma / fZeroThetaS );
+
+	return Yxy_to_RGB( Yp );
+}
+
+//vec3 ambient = (calculate_sky_luminance_RGB(-sun_direction, vec3(0, 1, 0), turbidity) + calculate_sky_luminance_RGB(-sun_direction, vec3(1, 0, 0), turbidity) + calculate_sky_luminance_RGB(-sun_direction, vec3(-1, 0, 0), turbidity) + calculate_sky_luminance_RGB(-sun_direction, vec3(0, 0, 1), turbidity) + calculate_sky_luminance_RGB(-sun_direction, vec3(0, 0, -1), turbidity))/5;
+
+// distance along the ray to the exit of the largest weather map cell that is guaranteed
+// to hold no cloud at any height, zero when the point lies in an occupied cell
+float get_empty_column_distance(vec3 point, vec3 dir)
+{
+    vec2 uvs = (point.xz + (wind_direction.xz)*time*cloud_speed + weather_map_min.xy)/(weather_map_scale);
+
+    ivec2 size = textureSize(occupancy_map, 0);
+    if (texelFetch(occupancy_map, min(ivec2(fract(uvs)*size), size - 1), 0).r > 0.0)
+    {
+        return 0.0;
+    }
+
+    // climb the pyramid while the enclosing cell is still empty
+    int level = 0;
+    while (level + 1 < occupancy_levels)
+    {
+        ivec2 level_size = textureSize(occupancy_map, level + 1);
+        if (texelFetch(occupancy_map, min(ivec2(fract(uvs)*level_size), level_size - 1), level + 1).r > 0.0)
+        {
+            break;
+        }
+        level++;
+    }
+
+    vec2 cells = vec2(textureSize(occupancy_map, level));
+    vec2 cell_min = floor(uvs*cells)/cells;
+    vec2 cell_max = cell_min + 1.0/cells;
+    vec2 uv_dir = dir.xz/weather_map_scale;
+
+    // dda step to the nearest cell boundary, rays parallel to an axis never leave through it
+    vec2 exit = vec2(1e30);
+    if (uv_dir.x > 0.0) exit.x = (cell_max.x - uvs.x)/uv_dir.x;
+    if (uv_dir.x < 0.0) exit.x = (cell_min.x - uvs.x)/uv_dir.x;
+    if (uv_dir.y > 0.0) exit.y = (cell_max.y - uvs.y)/uv_dir.y;
+    if (uv_dir.y < 0.0) exit.y = (cell_min.y - uvs.y)/uv_dir.y;
+
+    return min(exit.x, exit.y);
+}
+
+// distance along the ray to the exit of a cell of the density bounds at the given level
+float get_cell_exit_distance(vec3 point, vec3 dir, int level)
+{
+    point += wind_direction*(time - density_bounds_time)*cloud_speed;
+    vec3 cells = vec3(textureSize(density_bounds, level));
+    vec3 extent = (aabb_max - aabb_min)/cells;
+    vec3 cell_min = aabb_min + clamp(floor((point - aabb_min)/extent), vec3(0.0), cells - 1.0)*extent;
+    return max(intersect_aabb(point, dir, cell_min, cell_min + extent).y, 0.0);
+}
+
+vec2 get_cell_density_bounds(vec3 point, int level)
+{
+    point += wind_direction*(time - density_bounds_time)*cloud_speed;
+    ivec3 size = textureSize(density_bounds, level);
+    ivec3 cell = clamp(ivec3(floor((point - aabb_min)/(aabb_max - aabb_min)*vec3(size))), ivec3(0), size - 1);
+    return texelFetch(density_bounds, cell, level).rg;
+}
+
+// distance along the ray to the exit of the largest empty cell of the density bounds, zero when
+// the point lies in a cell which may hold cloud
+float get_empty_cell_distance(vec3 point, vec3 dir)
+{
+    if (get_cell_density_bounds(point, 0).y > 0.0)
+    {
+        return 0.0;
+    }
+
+    // climb the hierarchy while the enclosing cell is still empty
+    int level = 0;
+    while (level + 1 < density_bounds_levels && get_cell_density_bounds(point, level + 1).y <= 0.0)
+    {
+        level++;
+    }
+
+    return get_cell_exit_distance(point, dir, level);
+}
+
+bool skip_empty_space()
+{
+    return empty_space_skipping || use_brick_pool || density_bounds_skipping;
+}
+
+// distance the marcher can skip from the point, from the occupancy pyramid, empty bricks and the density bounds
+float get_empty_distance(vec3 point, vec3 dir)
+{
+    float empty_distance = empty_space_skipping ? get_empty_column_distance(point, dir) : 0.0;
+    if (use_brick_pool)
+    {
+        empty_distance = max(empty_distance, get_empty_brick_distance(point, dir));
+    }
+    if (density_bounds_skipping)
+    {
+        empty_distance = max(empty_distance, get_empty_cell_distance(point, dir));
+    }
+
+    return empty_distance;
+}
+
+vec3 phase(vec3 a, vec3 b)
+{
+	float costheta = dot(a, b);
+    return vec3(0.9*hg(costheta, 0.9) +0.1*hg(costheta, -0.5));
+}
+
+// offsets inside a cone of unit radius, one per light step
+const vec3 cone_kernel[8] = vec3[](
+    vec3( 0.19025653,  0.46226724, -0.01055672),
+    vec3(-0.45563219, -0.03231713, -0.77547076),
+    vec3(-0.09752765, -0.28367232,  0.00428638),
+    vec3( 0.06318367, -0.19163582,  0.67028615),
+    vec3( 0.28128598,  0.42443639, -0.86065785),
+    vec3(-0.06740961,  0.05899479,  0.38984042),
+    vec3( 0.61922085, -0.40977166,  0.29767308),
+    vec3(-0.37728339,  0.36901936, -0.28539226));
+
+// step i is twice as long as step i - 1 and the steps add up to the distance to the sun side exit,
+// samples spread over a cone and use coarser noise as they move away from the start point
+float get_sun_transmittance_cone(vec3 start_point, vec3 end_point)
+{
+    vec3 dir = normalize(end_point - start_point);
+    float len = length(end_point - start_point);
+
+    float step_size = len/(exp2(float(cone_light_steps)) - 1.0);
+    float base_texel_size = low_freq_noise_scale/textureSize(cloud_base, 0).x;
+
+    float distance_along_ray = 0.0;
+    float optical_depth = 0.0;
+
+    for (int i = 0; i < cone_light_steps; i++)
+    {
+        float sample_distance = distance_along_ray + 0.5*step_size;
+        float cone_radius = cone_spread*sample_distance;
+
+        vec3 sample_point = start_point + dir*sample_distance + cone_kernel[i % 8]*cone_radius;
+        samples_taken++;
+        secondary_samples++;
+        if (use_baked_density())
+        {
+            optical_depth += sample_baked_density(sample_point)*step_size;
+            distance_along_ray += step_size;
+            step_size *= 2.0;
+            continue;
+        }
+
+        float relative_height = clamp((sample_point.y - aabb_min.y)/(aabb_max.y - aabb_min.y), 0.0, 1.0);
+        vec3 sampling_point = sample_point + (wind_direction)*time*cloud_speed;
+        vec4 weather_data = texture(weather_map, (sampling_point.xz + weather_map_min.xy)/(weather_map_scale));
+
+        // a sample stands in for its whole step and the cone around it
+        float footprint = max(step_size, 2.0*cone_radius);
+        float lod = max(log2(footprint/base_texel_size), 0.0);
+
+        optical_depth += sample_cloud_density_lod(sampling_point, weather_data.xyz, relative_height, lod)*step_size;
+
+        distance_along_ray += step_size;
+        step_size *= 2.0;
+    }
+
+    return exp(-extinction_factor*optical_depth);
+}
+
+// transmittance from a point to the edge of the cloud layer towards the sun
+float get_sun_transmittance(vec3 start_point, vec3 end_point)
+{
+    if (use_light_volume)
+    {
+        // keep the lookup off the border texels, the volume does not wrap
+        vec3 half_texel = 0.5/vec3(textureSize(light_volume, 0));
+        vec3 baked_point = start_point + wind_direction*(time - light_volume_time)*cloud_speed;
+        vec3 uvw = clamp((baked_point - aabb_min)/(aabb_max - aabb_min), half_texel, 1.0 - half_texel);
+        return exp(-extinction_factor*texture(light_volume, uvw).r);
+    }
+
+    if (cone_light_march)
+    {
+        return get_sun_transmittance_cone(start_point, end_point);
+    }
+
+    float transmittance = 1.0;
+
+    vec3 dir = normalize(end_point - start_point);
+    float step_size = length(end_point - start_point)/(secondary_ray_steps + 1);
+
+    for (int i = 0; i < secondary_ray_steps; i++)
+    {
+        start_point += dir*step_size;
+
+        if (density_bounds_skipping)
+        {
+            vec2 bounds = get_cell_density_bounds(start_point, 0);
+            if (bounds.y <= 0.0)
+            {
+                continue;
+            }
+
+            // the minimum density alone extinguishes the rest of the way through the cell
+            if (transmittance*exp(-bounds.x*extinction_factor*get_cell_exit_distance(start_point, dir, 0)) < 0.00001)
+            {
+                return 0.0;
+            }
+        }
+
+        samples_taken++;
+        secondary_samples++;
+        if (use_baked_density())
+        {
+            transmittance *= exp(-sample_baked_density(start_point)*extinction_factor*step_size);
+            continue;
+        }
+
+        float relative_height = (start_point.y - aabb_min.y)/(aabb_max.y - aabb_min.y);
+        vec3 sampling_point = start_point + (wind_direction)*time*cloud_speed;
+        vec4 weather_data = texture(weather_map, (sampling_point.xz + weather_map_min.xy)/(weather_map_scale));
+        float cloud_density = sample_cloud_density(sampling_point, weather_data.xyz, relative_height);
+        transmittance *= exp(-cloud_density*extinction_factor*step_size);
+    }
+
+    return transmittance;
+}
+
+vec3 ray_march_to_sun(vec3 start_point, vec3 end_point, vec3 prev_dir)
+{
+    vec3 dir = normalize(end_point - start_point);
+
+    vec3 ph = phase(-dir, -prev_dir);
+
+    float transmittance = get_sun_transmittance(start_point, end_point);
+
+    return transmittance*ph*0.00006807*sun_luminance;
+}
+
+float Ei( float z )
+{
+    return 0.5772156649015328606065 + log( 1e-4 + abs(z) ) + z * (1.0 + z * (0.25 + z * ( (1.0/18.0) + z * ( (1.0/96.0) + z *
+(1.0/600.0) ) ) ) );
+}
+
+vec3 get_ambient_top(float relative_height, float cloud_density, vec4 height_profile, vec3 dir)
+{
+    float h = (height_profile.w - relative_height)*(aabb_max.y - aabb_min.y);
+    if (h < 0) return vec3(0);
+    float aa = -extinction_factor*cloud_density*h;
+    return 0.5*(ambient_luminance_up)*max(0, exp(aa));
+}
+
+vec3 get_ambient_bottom(float relative_height, float cloud_density, vec4 height_profile, vec3 dir)
+{
+    float hb = (relative_height - height_profile.z)*(aabb_max.y - aabb_min.y);
+    if (hb < 0) return vec3(0);
+    float aa = -extinction_factor*cloud_density*hb;
+    return 0.5*(ambient_luminance_down)*max(0, exp(aa));
+}
+
+vec3 ray_march_to_sun_ms(vec3 start_point, vec3 end_point, vec3 prev_dir)
+{
+    vec3 dir = normalize(end_point - start_point);
+
+    float transmittance = get_sun_transmittance(start_point, end_point);
+
+    vec3 retval = vec3(0);
+
+    float costheta = dot(-dir, -prev_dir);
+
+    if (use_multiple_scattering_lut)
+    {
+        // same parametrisation as multiple_scattering.comp, the end texels hold the exact end points
+        vec2 coords = sqrt(vec2(transmittance, clamp(0.5 - 0.5*costheta, 0.0, 1.0)));
+        vec2 size = vec2(textureSize(multiple_scattering_lut, 0));
+        return texture(multiple_scattering_lut, (coords*(size - 1.0) + 0.5)/size).rgb*0.00006807*sun_luminance;
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        vec3 ph = phase_ms(costheta, c, i);
+        retval += pow(b, i/2.0)*pow(transmittance, pow(a,i/2.0))*(ph*0.00006807*sun_luminance);
+    }
+
+    return retval;
+}
+
+// state of a primary ray between march segments, the compute marcher keeps it in shared memory
+struct ray_state_t
+{
+    vec3 start_point;
+    vec3 dir;
+    vec3 current_point;
+    vec3 colour;
+    float len;
+    float step_size;
+    float distance_marched;
+    float transmittance;
+    float weighted_depth;
+    float depth_weight;
+    int step;
+    int empty_steps;
+    bool in_cloud;
+    bool done;
+    // cost of this ray, lanes of the compute marcher march other rays than their own
+    ivec3 cost;
+};
+
+ray_state_t begin_ray_march(vec3 start_point, vec3 end_point)
+{
+    ray_state_t ray;
+    ray.dir = normalize(end_point - start_point);
+    ray.len = length(end_point - start_point);
+    ray.step_size = ray.len/(primary_ray_steps+1);
+
+    if (use_blue_noise == 1.0)
+    {
+        vec2 sample_uvs = (pixel_coords + blue_noise_offset)/textureSize(blue_noise, 0);
+        vec3 noise = texture(blue_noise, sample_uvs).rgb;
+        start_point += noise*ray.step_size;
+    }
+
+    // start marching from the beginning
+    ray.start_point = start_point;
+    ray.current_point = start_point;
+    ray.colour = vec3(0);
+    ray.transmittance = 1.0;
+
+    // depth of the cloud weighted by how much each step attenuates the ray
+    ray.weighted_depth = 0.0;
+    ray.depth_weight = 0.0;
+
+    ray.distance_marched = 0.0;
+    ray.step = 0;
+    ray.empty_steps = 0;
+    ray.in_cloud = false;
+    ray.done = false;
+    ray.cost = ivec3(0);
+
+    return ray;
+}
+
+// marches at most the given number of steps, the ray is done once it leaves the layer or turns opaque
+void march_segment(inout ray_state_t ray, int steps)
+{
+    vec3 start_point = ray.start_point;
+    vec3 dir = ray.dir;
+    vec3 current_point = ray.current_point;
+    vec3 colour = ray.colour;
+    float len = ray.len;
+    float step_size = ray.step_size;
+    float transmittance = ray.transmittance;
+    float weighted_depth = ray.weighted_depth;
+    float depth_weight = ray.depth_weight;
+
+    // adaptive marching state, fine steps are as long as the fixed steps
+    float coarse_step_size = step_size*coarse_step_factor;
+    float distance_marched = ray.distance_marched;
+    bool in_cloud = ray.in_cloud;
+    int empty_steps = ray.empty_steps;
+    // widening sooner than a coarse step could find the same cloud edge again
+    int widening_threshold = max(empty_steps_before_widening, coarse_step_factor);
+    int max_steps = adaptive_step_size ? 2*primary_ray_steps : primary_ray_steps;
+
+    ivec3 counters_before = get_cost_counters();
+    bool done = false;
+    int i = ray.step;
+    int last_step = min(ray.step + steps, max_steps);
+
+    for (; i < last_step; i++)
+    {
+        if (adaptive_step_size && !in_cloud)
+        {
+            if (distance_marched + coarse_step_size > len)
+            {
+                done = true;
+                break;
+            }
+
+            // march forwards with a coarse step and a cheap density test
+            distance_marched += coarse_step_size;
+            current_point = start_point + dir*distance_marched;
+
+            if (skip_empty_space())
+            {
+                // stay on the fine step grid so samples match the fixed step marcher
+                float empty_distance = min(get_empty_distance(current_point, dir), len);
+                if (empty_distance > 0.0)
+                {
+                    distance_marched += floor(empty_distance/step_size)*step_size;
+                    continue;
+                }
+            }
+            float coarse_density;
+            samples_taken++;
+            primary_steps++;
+            if (use_baked_density())
+            {
+                coarse_density = sample_baked_density(current_point);
+            }
+            else
+            {
+                float relative_height = (current_point.y - aabb_min.y)/(aabb_max.y - aabb_min.y);
+                vec3 sampling_location = current_point + (wind_direction)*time*cloud_speed;
+                vec4 weather_data = texture(weather_map, (sampling_location.xz + weather_map_min.xy)/(weather_map_scale));
+                coarse_density = sample_cloud_density_coarse(sampling_location, weather_data.xyz, relative_height);
+            }
+
+            if (coarse_density > 0.0)
+            {
+                // back up and walk into the cloud with fine steps
+                distance_marched -= coarse_step_size;
+                in_cloud = true;
+                empty_steps = 0;
+            }
+
+            continue;
+        }
+
+        // march forwards
+        if (adaptive_step_size)
+        {
+            if (distance_marched + step_size > len)
+            {
+                done = true;
+                break;
+            }
+            distance_marched += step_size;
+            current_point = start_point + dir*distance_marched;
+        }
+        else
+        {
+            current_point += dir*step_size;
+
+            if (skip_empty_space())
+            {
+                // skip every step that still lies inside the empty cell
+                float empty_distance = get_empty_distance(current_point, dir);
+                if (empty_distance > 0.0)
+                {
+                    int skipped_steps = int(min(empty_distance, len)/step_size);
+                    current_point += dir*step_size*skipped_steps;
+                    i += skipped_steps;
+                    continue;
+                }
+            }
+        }
+
+        // compute relative height in cloud layer
+        float relative_height = (current_point.y - aabb_min.y)/(aabb_max.y - aabb_min.y);
+
+        // sample extinction and scattering coefficient for current position based on cloud density
+        vec3 sampling_location = current_point + (wind_direction)*time*cloud_speed;
+        samples_taken++;
+        primary_steps++;
+        float cloud_density = use_baked_density() ? sample_baked_density(current_point) : 0.0;
+        vec4 weather_data = vec4(0);
+        if (!use_baked_density())
+        {
+            weather_data = texture(weather_map, (sampling_location.xz + weather_map_min.xy)/(weather_map_scale));
+            if (detail_lod)
+            {
+                float view_distance = length(current_point - camera_pos);
+                cloud_density = sample_cloud_density_footprint(sampling_location, weather_data.xyz, relative_height, view_distance*pixel_angle, view_distance);
+            }
+            else
+            {
+                cloud_density = sample_cloud_density(sampling_location, weather_data.xyz, relative_height);
+            }
+        }
+
+        if (adaptive_step_size)
+        {
+            // empty samples contribute nothing, skip lighting and widen after a run of them
+            if (cloud_density <= 0.0)
+            {
+                empty_steps++;
+                in_cloud = empty_steps < widening_threshold;
+                continue;
+            }
+
+            empty_steps = 0;
+        }
+
+        float extinction_coefficient = extinction_factor*cloud_density;
+        float scattering_coefficient = scattering_factor*cloud_density;
+
+        // compute radiance from sun
+        vec3 dir_to_sun = -sun_direction;
+
+        vec2 inter = intersect_aabb(current_point, dir_to_sun, aabb_min, aabb_max);
+        vec3 end_point_to_sun = inter.y*dir_to_sun + current_point;
+
+        vec3 radiance;
+        if (multiple_scattering_approximation == 1.0)
+        {
+             radiance =  ray_march_to_sun_ms(current_point, end_point_to_sun, dir);
+        }
+        else 
+        {
+             radiance =  ray_march_to_sun(current_point, end_point_to_sun, dir);
+        }
+
+        if (use_ambient)
+        {
+           // the cloud type is still needed for the ambient height terms
+           if (use_baked_density())
+           {
+               weather_data = texture(weather_map, (sampling_location.xz + weather_map_min.xy)/(weather_map_scale));
+           }
+           vec4 height_profile = get_height_profile(relative_height, weather_data.z);
+           radiance += (get_ambient_top(relative_height, cloud_density, height_profile, dir) + get_ambient_bottom(relative_height, cloud_density, height_profile, dir));
+           //radiance = (get_ambient_top(relative_height, cloud_density, weather_data.z, dir) + get_ambient_bottom(relative_height, cloud_density, weather_data.z, dir));
+        }
+
+        // compute current  and extinction contribution
+        float current_transmittance = exp(-extinction_coefficient*step_size);
+        vec3 current_scattering = scattering_coefficient*(radiance - radiance*current_transmittance)/max(extinction_coefficient,  0.0000001);
+
+        // accumulate scattering and extinction
+        colour += transmittance*current_scattering;
+
+        float attenuation = transmittance - transmittance*current_transmittance;
+        weighted_depth += attenuation*length(current_point - camera_pos);
+        depth_weight += attenuation;
+
+        transmittance *= current_transmittance;
+
+        if (transmittance < 0.00001)
+        {
+            done = true;
+            break;
+        }
+    }
+
+    ray.current_point = current_point;
+    ray.colour = colour;
+    ray.transmittance = transmittance;
+    ray.weighted_depth = weighted_depth;
+    ray.depth_weight = depth_weight;
+    ray.distance_marched = distance_marched;
+    ray.in_cloud = in_cloud;
+    ray.empty_steps = empty_steps;
+    ray.step = i;
+    ray.done = done || i >= max_steps;
+    ray.cost += get_cost_counters() - counters_before;
+}
+
+vec4 end_ray_march(ray_state_t ray, out float cloud_depth)
+{
+    cloud_depth = ray.depth_weight > 0.0 ? cloud_depth_scale*ray.weighted_depth/ray.depth_weight : sky_depth;
+
+    return vec4(ray.colour, ray.transmittance);
+}
+
+vec4 ray_march(vec3 start_point, vec3 end_point, out float cloud_depth)
+{
+    ray_state_t ray = begin_ray_march(start_point, end_point);
+    march_segment(ray, 2*primary_ray_steps);
+    return end_ray_march(ray, cloud_depth);
+}
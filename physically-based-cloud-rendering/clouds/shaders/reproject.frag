@@ -0,0 +1,88 @@
+#version 460 core
+layout(location = 0) out vec4 fragment_colour;
+layout(location = 1) out vec4 cloud_data;
+
+in vec2 uvs;
+
+// one freshly marched pixel per block
+uniform sampler2D current_colour;
+uniform sampler2D current_cloud_data;
+
+// previous resolved frame
+uniform sampler2D history_colour;
+uniform sampler2D history_cloud_data;
+
+uniform int block_size;
+uniform ivec2 pixel_offset;
+uniform bool history_valid;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 previous_view_projection;
+uniform vec3 camera_pos;
+
+uniform float depth_tolerance = 0.1;
+
+// must match raymarch.frag
+const float cloud_depth_scale = 0.001;
+const float sky_depth = 100.0;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 block = pixel/block_size;
+
+    vec4 fresh_colour = texelFetch(current_colour, block, 0);
+    vec4 fresh_data = texelFetch(current_cloud_data, block, 0);
+
+    if (pixel - block*block_size == pixel_offset)
+    {
+        fragment_colour = fresh_colour;
+        cloud_data = vec4(fresh_data.xy, 0.0, 1.0);
+        return;
+    }
+
+    // until re-marched, disoccluded pixels hold the block's fresh sample
+    fragment_colour = fresh_colour;
+    cloud_data = vec4(fresh_data.xy, 1.0, 1.0);
+
+    if (!history_valid)
+    {
+        return;
+    }
+
+    // same ray as raymarch.frag, the block's cloud depth stands in for the pixel's
+    vec4 ray_clip = vec4(uvs*2.0 - 1.0, -1.0, 1.0);
+    vec4 ray_eye = inverse(projection)*ray_clip;
+    ray_eye = vec4(ray_eye.xy, -1.0, 0.0);
+    vec3 ray_world = normalize((inverse(view)*ray_eye).xyz);
+
+    float depth = fresh_data.x;
+
+    // the sky only depends on the direction
+    vec4 previous_clip = depth >= sky_depth
+        ? previous_view_projection*vec4(ray_world, 0.0)
+        : previous_view_projection*vec4(camera_pos + ray_world*depth/cloud_depth_scale, 1.0);
+
+    if (previous_clip.w <= 0.0)
+    {
+        return;
+    }
+
+    vec2 previous_uvs = previous_clip.xy/previous_clip.w*0.5 + 0.5;
+    if (any(lessThan(previous_uvs, vec2(0.0))) || any(greaterThan(previous_uvs, vec2(1.0))))
+    {
+        return;
+    }
+
+    vec4 history = texture(history_colour, previous_uvs);
+    vec4 history_data = texture(history_cloud_data, previous_uvs);
+
+    if (abs(history_data.x - depth)/max(depth, 0.001) > depth_tolerance)
+    {
+        return;
+    }
+
+    fragment_colour = history;
+    cloud_data = vec4(history_data.xy, 0.0, 1.0);
+}
@@ -60,7 +60,10 @@ vec3 apply_gamma(vec3 colour)
 
 void main()
 {             
-    vec3 colour = texture(full_screen, uvs).rgb;
+    // the image is upscaled to the window, clamping to the outer texel centres keeps the
+    // bilinear taps from wrapping around the edges
+    vec2 half_texel = 0.5/vec2(textureSize(full_screen, 0));
+    vec3 colour = texture(full_screen, clamp(uvs, half_texel, 1.0 - half_texel)).rgb;
 
     colour = apply_exposure(colour);
 	colour = tone_map(colour);
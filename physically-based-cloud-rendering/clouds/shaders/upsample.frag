@@ -0,0 +1,64 @@
+#version 460 core
+layout(location = 0) out vec4 fragment_colour;
+layout(location = 1) out vec4 cloud_data;
+
+in vec2 uvs;
+
+uniform sampler2D low_resolution_colour;
+uniform sampler2D low_resolution_cloud_data;
+uniform float depth_sigma = 0.1;
+uniform float transmittance_sigma = 0.2;
+
+const ivec2 offsets[4] = ivec2[](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(1, 1));
+
+void main()
+{
+    ivec2 low_resolution_size = textureSize(low_resolution_colour, 0);
+    vec2 position = uvs*vec2(low_resolution_size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = fract(position);
+
+    float bilinear_weights[4] = float[](
+        (1.0 - f.x)*(1.0 - f.y),
+        f.x*(1.0 - f.y),
+        (1.0 - f.x)*f.y,
+        f.x*f.y);
+
+    vec4 colours[4];
+    vec4 data[4];
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 texel = clamp(base + offsets[i], ivec2(0), low_resolution_size - 1);
+        colours[i] = texelFetch(low_resolution_colour, texel, 0);
+        data[i] = texelFetch(low_resolution_cloud_data, texel, 0);
+    }
+
+    // the closest low resolution texel is the reference every other tap is compared against
+    int nearest = int(f.x >= 0.5) + 2*int(f.y >= 0.5);
+    float reference_depth = data[nearest].x;
+    float reference_transmittance = data[nearest].y;
+
+    vec4 colour = vec4(0.0);
+    vec4 cloud = vec4(0.0);
+    float total_weight = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        float depth_difference = abs(data[i].x - reference_depth)/max(reference_depth, 0.001);
+        float transmittance_difference = abs(data[i].y - reference_transmittance);
+        float weight = bilinear_weights[i]*exp(-depth_difference/depth_sigma)*exp(-transmittance_difference/transmittance_sigma);
+
+        colour += weight*colours[i];
+        cloud += weight*data[i];
+        total_weight += weight;
+    }
+
+    if (total_weight < 0.0001)
+    {
+        fragment_colour = colours[nearest];
+        cloud_data = data[nearest];
+        return;
+    }
+
+    fragment_colour = colour/total_weight;
+    cloud_data = cloud/total_weight;
+}
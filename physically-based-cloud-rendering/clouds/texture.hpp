@@ -1,5 +1,7 @@
 #pragma once
 
+#include "profiler.hpp"
+
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -29,6 +31,10 @@ public:
         gl::glGenTextures(1, &id_);
         assert(id_);
 
+        // a mipmapped minification filter gets the levels below the uploaded one generated from it, other
+        // textures only allocate the base level
+        const auto mipmapped = filtering_min != gl::GLenum::GL_LINEAR && filtering_min != gl::GLenum::GL_NEAREST;
+
         if constexpr (Dimensions == 1) {
             glBindTexture(gl::GLenum::GL_TEXTURE_1D, id_);
             glTexParameteri(gl::GLenum::GL_TEXTURE_1D, gl::GLenum::GL_TEXTURE_MIN_FILTER, filtering_min);
@@ -36,10 +42,11 @@ public:
             glTexParameteri(gl::GLenum::GL_TEXTURE_1D, gl::GLenum::GL_TEXTURE_WRAP_S, wrap_s);
             glTexParameteri(gl::GLenum::GL_TEXTURE_1D, gl::GLenum::GL_TEXTURE_WRAP_T, wrap_t);
 
-            const auto levels = static_cast<uint32_t>(floor(log2(texture_width))) + 1;
+            const auto levels = mipmapped ? static_cast<uint32_t>(floor(log2(texture_width))) + 1 : 1;
             glTexStorage1D(gl::GLenum::GL_TEXTURE_1D, levels, sized_internal_format, texture_width);
 
             if (texture_path != nullptr) {
+                const auto zone = profile_zone_t{"decode texture", texture_path};
                 auto       width{0};
                 auto       height{0};
                 auto       number_of_components{0};
@@ -47,6 +54,9 @@ public:
 
                 glTexSubImage1D(gl::GLenum::GL_TEXTURE_1D, 0, 0, texture_width, format, type, out);
                 stbi_image_free(out);
+                if (mipmapped) {
+                    glGenerateMipmap(gl::GLenum::GL_TEXTURE_1D);
+                }
             }
         } else if constexpr (Dimensions == 2) {
             glBindTexture(gl::GLenum::GL_TEXTURE_2D, id_);
@@ -55,10 +65,11 @@ public:
             glTexParameteri(gl::GLenum::GL_TEXTURE_2D, gl::GLenum::GL_TEXTURE_WRAP_S, wrap_s);
             glTexParameteri(gl::GLenum::GL_TEXTURE_2D, gl::GLenum::GL_TEXTURE_WRAP_T, wrap_t);
 
-            const auto levels = static_cast<uint32_t>(floor(log2(std::max(texture_width, texture_height)))) + 1;
+            const auto levels = mipmapped ? static_cast<uint32_t>(floor(log2(std::max(texture_width, texture_height)))) + 1 : 1;
             glTexStorage2D(gl::GLenum::GL_TEXTURE_2D, levels, sized_internal_format, texture_width, texture_height);
 
             if (texture_path != nullptr) {
+                const auto zone = profile_zone_t{"decode texture", texture_path};
                 auto       width{0};
                 auto       height{0};
                 auto       number_of_components{0};
@@ -66,6 +77,9 @@ public:
                 glTexSubImage2D(gl::GLenum::GL_TEXTURE_2D, 0, 0, 0, texture_width, texture_height, format, type, out);
                 glTexImage2D(gl::GLenum::GL_TEXTURE_2D, 0, sized_internal_format, texture_width, texture_height, 0, format, type, out);
                 stbi_image_free(out);
+                if (mipmapped) {
+                    glGenerateMipmap(gl::GLenum::GL_TEXTURE_2D);
+                }
             }
         } else {
             glBindTexture(gl::GLenum::GL_TEXTURE_3D, id_);
@@ -75,10 +89,11 @@ public:
             glTexParameteri(gl::GLenum::GL_TEXTURE_3D, gl::GLenum::GL_TEXTURE_MIN_FILTER, filtering_min);
             glTexParameteri(gl::GLenum::GL_TEXTURE_3D, gl::GLenum::GL_TEXTURE_MAG_FILTER, filtering_mag);
 
-            const auto levels = static_cast<uint32_t>(floor(log2(std::max({texture_width, texture_height, texture_depth})))) + 1;
+            const auto levels = mipmapped ? static_cast<uint32_t>(floor(log2(std::max({texture_width, texture_height, texture_depth})))) + 1 : 1;
             glTexStorage3D(gl::GLenum::GL_TEXTURE_3D, levels, sized_internal_format, texture_width, texture_height, texture_depth);
 
             if (texture_path != nullptr) {
+                const auto zone = profile_zone_t{"decode texture", texture_path};
                 auto       width{0};
                 auto       height{0};
                 auto       number_of_components{0};
@@ -86,6 +101,9 @@ public:
 
                 glTexSubImage3D(gl::GLenum::GL_TEXTURE_3D, 0, 0, 0, 0, texture_width, texture_height, texture_depth, format, type, out);
                 stbi_image_free(out);
+                if (mipmapped) {
+                    glGenerateMipmap(gl::GLenum::GL_TEXTURE_3D);
+                }
             }
         }
     }